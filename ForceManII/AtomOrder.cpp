@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "ForceManII/AtomOrder.hpp"
+#include <algorithm>
+#include <numeric>
+
+using namespace std;
+namespace FManII {
+namespace detail {
+
+//Spreads the lowest 21 bits of x out so there are two 0 bits between each
+inline uint64_t spread_bits(uint64_t x){
+    x&=0x1fffff;
+    x=(x|x<<32)&0x1f00000000ffffULL;
+    x=(x|x<<16)&0x1f0000ff0000ffULL;
+    x=(x|x<<8)&0x100f00f00f00f00fULL;
+    x=(x|x<<4)&0x10c30c30c30c30c3ULL;
+    x=(x|x<<2)&0x1249249249249249ULL;
+    return x;
+}
+
+uint64_t morton_key(uint32_t x,uint32_t y,uint32_t z){
+    return spread_bits(x)<<2|spread_bits(y)<<1|spread_bits(z);
+}
+
+//Uses J. Skilling's transpose algorithm (AIP Conf. Proc. 707, 381 (2004)):
+//the grid point is transformed in place into the Hilbert index, with the
+//index's bits dealt out round robin among the three coordinates
+uint64_t hilbert_key(uint32_t x,uint32_t y,uint32_t z){
+    uint32_t X[3]={x,y,z};
+    const uint32_t M=1u<<(curve_bits-1);
+    for(uint32_t Q=M;Q>1;Q>>=1){
+        const uint32_t P=Q-1;
+        for(size_t i=0;i<3;++i){
+            if(X[i]&Q)X[0]^=P;//Invert
+            else{//Exchange
+                const uint32_t t=(X[0]^X[i])&P;
+                X[0]^=t;
+                X[i]^=t;
+            }
+        }
+    }
+    //Gray encode
+    for(size_t i=1;i<3;++i)X[i]^=X[i-1];
+    uint32_t t=0;
+    for(uint32_t Q=M;Q>1;Q>>=1)
+        if(X[2]&Q)t^=Q-1;
+    for(size_t i=0;i<3;++i)X[i]^=t;
+    return morton_key(X[0],X[1],X[2]);
+}
+
+} //End namespace detail
+
+IVector curve_order(const Vector& carts,AtomOrder order){
+    const size_t natoms=carts.size()/3;
+    IVector rv(natoms);
+    iota(rv.begin(),rv.end(),0);
+    if(order==AtomOrder::INPUT||natoms<2)return rv;
+
+    double lo[3],hi[3];
+    for(size_t x=0;x<3;++x){
+        lo[x]=hi[x]=carts[x];
+        for(size_t i=1;i<natoms;++i){
+            lo[x]=std::min(lo[x],carts[3*i+x]);
+            hi[x]=std::max(hi[x],carts[3*i+x]);
+        }
+    }
+    //One scale for all three axes keeps the grid cells cubes
+    const double extent=std::max(hi[0]-lo[0],std::max(hi[1]-lo[1],hi[2]-lo[2]));
+    const double max_grid=(1u<<detail::curve_bits)-1,
+                 scale=extent>0.0?max_grid/extent:0.0;
+    vector<uint64_t> keys(natoms);
+    for(size_t i=0;i<natoms;++i){
+        uint32_t g[3];
+        for(size_t x=0;x<3;++x)
+            g[x]=static_cast<uint32_t>((carts[3*i+x]-lo[x])*scale);
+        keys[i]=order==AtomOrder::MORTON?detail::morton_key(g[0],g[1],g[2]):
+                                         detail::hilbert_key(g[0],g[1],g[2]);
+    }
+    stable_sort(rv.begin(),rv.end(),[&](size_t i,size_t j){
+        return keys[i]<keys[j];
+    });
+    return rv;
+}
+
+} //End namespace FManII
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+#include "ForceManII/FManIIDefs.hpp"
+#include <cstdint>
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+
+///Ways of numbering the atoms of a system
+enum class AtomOrder{
+    INPUT,///<The order the atoms were given in
+    MORTON,///<Along a Morton (Z-order) curve through the atoms
+    HILBERT///<Along a Hilbert curve through the atoms
+};
+
+/** \brief Numbers atoms so that atoms close in space are close in number
+ *
+ *  The bounding box of the atoms is divided into a \f$2^{21}\f$ per side grid
+ *  and the atoms are sorted by the position of their grid point along the
+ *  requested space-filling curve (ties keep their input order).  Hilbert
+ *  curves never jump, so they usually give slightly better locality than
+ *  Morton curves, which are cheaper to compute.
+ *
+ *  \param[in] carts The Cartesian coordinates of the atoms
+ *  \param[in] order The curve to follow
+ *  \return Element i is the input number of the i-th atom along the curve
+ */
+IVector curve_order(const Vector& carts,AtomOrder order);
+
+namespace detail {
+
+///Bits per dimension of the grid curve_order() sorts on
+constexpr unsigned curve_bits=21;
+
+///Position of grid point (x,y,z) along a Morton curve
+std::uint64_t morton_key(std::uint32_t x,std::uint32_t y,std::uint32_t z);
+
+///Position of grid point (x,y,z) along a Hilbert curve
+std::uint64_t hilbert_key(std::uint32_t x,std::uint32_t y,std::uint32_t z);
+
+} //End namespace detail
+} //End namespace FManII
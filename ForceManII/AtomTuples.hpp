@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+#include "ForceManII/Common.hpp"
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+
+///Type used to store atom numbers in bulk.  Four bytes are plenty: every pair
+///of atoms is an internal coordinate, so far fewer than 2^32 atoms fit in
+///memory, and it halves the memory (and bandwidth) used by the pair lists.
+using Index_t=std::uint32_t;
+
+///The most atoms any internal coordinate depends on
+constexpr size_t max_arity=4;
+
+///The atoms of one internal coordinate, stored by value
+class AtomTuple{
+    std::array<Index_t,max_arity> atoms_;
+    Index_t n_;
+    template<typename Itr>
+    void set(Itr begin,size_t n){
+        DEBUG_CHECK(n<=max_arity,"Internal coordinates have at most "+
+                    std::to_string(max_arity)+" atoms");
+        n_=static_cast<Index_t>(n);
+        for(size_t i=0;i<n;++i,++begin)atoms_[i]=static_cast<Index_t>(*begin);
+    }
+public:
+    ///Copies the \p n atoms starting at \p atoms
+    explicit AtomTuple(const Index_t* atoms,size_t n){set(atoms,n);}
+    ///Copies the atoms in \p atoms
+    AtomTuple(const std::vector<size_t>& atoms){set(atoms.begin(),atoms.size());}
+    ///Copies the atoms in \p atoms, e.g. deriv(0,carts,{0,1})
+    AtomTuple(std::initializer_list<size_t> atoms){
+        set(atoms.begin(),atoms.size());
+    }
+
+    size_t size()const{return n_;}
+    size_t operator[](size_t i)const{return atoms_[i];}
+    const Index_t* begin()const{return atoms_.data();}
+    const Index_t* end()const{return atoms_.data()+n_;}
+};
+
+/** \brief The atoms of every internal coordinate of one type
+ *
+ *  All of the coordinates of one type have the same number of atoms (the
+ *  arity, e.g. 2 for bonds and 4 for torsions) so they are stored back to back
+ *  in one array, the atoms of the i-th coordinate start at element i*arity.
+ *  Compared to one vector per coordinate this saves a heap allocation and a
+ *  pointer per coordinate and lets loops over the coordinates stream through
+ *  memory.
+ */
+class AtomTuples{
+    size_t arity_=0;
+    std::vector<Index_t> atoms_;
+public:
+    ///Iterates over the coordinates, dereferencing to an AtomTuple
+    class const_iterator{
+        const Index_t* p_;
+        size_t arity_;
+    public:
+        const_iterator(const Index_t* p,size_t arity):p_(p),arity_(arity){}
+        AtomTuple operator*()const{return AtomTuple(p_,arity_);}
+        const_iterator& operator++(){p_+=arity_;return *this;}
+        bool operator==(const const_iterator& o)const{return p_==o.p_;}
+        bool operator!=(const const_iterator& o)const{return p_!=o.p_;}
+    };
+
+    ///Makes an empty list, the arity is set by the first push_back
+    AtomTuples()=default;
+    ///Makes an empty list of coordinates with \p arity atoms each
+    explicit AtomTuples(size_t arity):arity_(arity){}
+
+    ///The number of atoms in each coordinate, 0 if not yet known
+    size_t arity()const{return arity_;}
+    ///The number of coordinates
+    size_t size()const{return arity_?atoms_.size()/arity_:0;}
+    bool empty()const{return atoms_.empty();}
+
+    ///The atoms of the \p i-th coordinate
+    AtomTuple operator[](size_t i)const{
+        return AtomTuple(atoms_.data()+i*arity_,arity_);
+    }
+    const_iterator begin()const{return const_iterator(atoms_.data(),arity_);}
+    const_iterator end()const{
+        return const_iterator(atoms_.data()+atoms_.size(),arity_);
+    }
+
+    ///All of the atoms, arity() per coordinate
+    const std::vector<Index_t>& data()const{return atoms_;}
+
+    ///Makes room for \p n coordinates
+    void reserve(size_t n){atoms_.reserve(n*arity_);}
+
+    ///Adds a coordinate, it must have as many atoms as the others
+    void push_back(const AtomTuple& atoms){
+        if(!arity_)arity_=atoms.size();
+        CHECK(atoms.size()==arity_,"Coordinate has "+
+              std::to_string(atoms.size())+" atoms, expected "+
+              std::to_string(arity_));
+        atoms_.insert(atoms_.end(),atoms.begin(),atoms.end());
+    }
+};
+
+} //End namespace FManII
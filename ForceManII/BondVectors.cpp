@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "ForceManII/BondVectors.hpp"
+#include "ForceManII/Cell.hpp"
+#include "ForceManII/Util.hpp"
+#include "ForceManII/InternalCoords/Angle.hpp"
+#include "ForceManII/InternalCoords/ImproperTorsion.hpp"
+#include <algorithm>
+
+using namespace std;
+namespace FManII {
+
+BondVectors::BondVectors(const Vector& carts,const AtomTuples& bonds,
+                         const Cell* cell):
+    r_(3*bonds.size()),length_(bonds.size())
+{
+    const Index_t* atoms=bonds.data().data();
+    for(size_t b=0;b<bonds.size();++b){
+        array<double,3> dr=diff(&carts[3*atoms[2*b]],&carts[3*atoms[2*b+1]]);
+        if(cell)dr=cell->minimum_image(dr);
+        copy(dr.begin(),dr.end(),&r_[3*b]);
+        length_[b]=mag(dr);
+    }
+}
+
+bool BondRefs::find(const string& type,const AtomTuples& coords,
+                    const AtomTuples& bonds,size_t natoms,BondRefs& rv){
+    //Which pairs of atoms each kind needs, as (i,j) for q_i-q_j
+    using Pairs=vector<array<size_t,2>>;
+    BondRefs refs;
+    Pairs pairs;
+    if(type==IntCoord_t::ANGLE){
+        refs.kind_=Kind::ANGLE;
+        pairs={{{0,1}},{{2,1}}};
+    }
+    else if(type==IntCoord_t::TORSION){
+        refs.kind_=Kind::TORSION;
+        pairs={{{1,0}},{{1,2}},{{2,3}}};
+    }
+    else if(type==IntCoord_t::IMPTORSION){
+        refs.kind_=Kind::IMPTORSION;
+        pairs={{{1,0}},{{1,2}},{{1,3}}};
+    }
+    else return false;
+
+    //Bonds of each atom sorted by the other atom, in compressed form
+    vector<Index_t> offsets(natoms+1,0);
+    const Index_t* bond_atoms=bonds.data().data();
+    for(size_t x=0;x<2*bonds.size();++x){
+        CHECK(bond_atoms[x]<natoms,"Bond to an atom that does not exist");
+        ++offsets[bond_atoms[x]+1];
+    }
+    for(size_t i=0;i<natoms;++i)offsets[i+1]+=offsets[i];
+    vector<pair<Index_t,Index_t>> partners(offsets.back());//(other atom,ref)
+    vector<Index_t> next(offsets.begin(),offsets.end()-1);
+    for(size_t b=0;b<bonds.size();++b){
+        const Index_t i=bond_atoms[2*b],j=bond_atoms[2*b+1];
+        partners[next[i]++]={j,static_cast<Index_t>(2*b)};
+        partners[next[j]++]={i,static_cast<Index_t>(2*b+1)};
+    }
+    for(size_t i=0;i<natoms;++i)
+        sort(partners.begin()+offsets[i],partners.begin()+offsets[i+1]);
+
+    refs.nbonds_=pairs.size();
+    refs.refs_.reserve(coords.size()*pairs.size());
+    for(const AtomTuple atoms:coords)
+        for(const auto& p:pairs){
+            const Index_t i=atoms[p[0]],j=atoms[p[1]];
+            if(i>=natoms)return false;
+            const auto first=partners.begin()+offsets[i],
+                       last=partners.begin()+offsets[i+1];
+            const auto bond=lower_bound(first,last,make_pair(j,Index_t(0)));
+            if(bond==last || bond->first!=j)return false;
+            refs.refs_.push_back(bond->second);
+        }
+    rv=move(refs);
+    return true;
+}
+
+void BondRefs::deriv(size_t order,const BondVectors& bonds,size_t i,
+                     double* out)const{
+    array<array<double,3>,3> r;
+    for(size_t k=0;k<nbonds_;++k){
+        const Index_t ref=refs_[i*nbonds_+k];
+        DEBUG_CHECK(ref/2<bonds.size(),"Bond vectors are out of date");
+        r[k]=bonds.vector(ref/2);
+        if(ref%2)
+            for(double& x:r[k])x=-x;
+    }
+    switch(kind_){
+        case Kind::ANGLE:Angle::bond_deriv(order,r[0],r[1],out);break;
+        case Kind::TORSION:Torsion::bond_deriv(order,r[0],r[1],r[2],out);break;
+        case Kind::IMPTORSION:
+            ImproperTorsion::bond_deriv(order,r[0],r[1],r[2],out);break;
+    }
+}
+
+} //End namespace FManII
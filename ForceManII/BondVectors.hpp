@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+#include "ForceManII/AtomTuples.hpp"
+#include <map>
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+class Cell;
+
+/** \brief The vector along each bond of a system, and its length, at one
+ *         geometry
+ *
+ *  Angles, torsions, and impropers are all made of bonds, so rather than each
+ *  of them subtracting the Cartesian coordinates of its atoms, the bond
+ *  vectors are computed once per geometry and the coordinates refer to them
+ *  by index (see BondRefs).  The vector of bond b, whose atoms are (i,j), is
+ *  \f$q_i-q_j\f$ (the minimum image of it if the system is periodic).
+ */
+class BondVectors{
+    std::vector<double> r_,length_;
+public:
+    ///Makes the vectors of no bonds
+    BondVectors()=default;
+
+    ///Computes the vectors of \p bonds at \p carts
+    BondVectors(const std::vector<double>& carts,const AtomTuples& bonds,
+                const Cell* cell);
+
+    ///The number of bonds
+    size_t size()const{return length_.size();}
+
+    ///The vector of bond \p b
+    std::array<double,3> vector(size_t b)const{
+        return {r_[3*b],r_[3*b+1],r_[3*b+2]};
+    }
+
+    ///The length of each bond
+    const std::vector<double>& lengths()const{return length_;}
+};
+
+/** \brief The bonds each angle, torsion, or improper of a system is made of
+ *
+ *  A reference to bond b is stored as 2b, or 2b+1 if the coordinate needs the
+ *  bond vector pointing the other way.  An angle i-j-k refers to the bonds
+ *  for \f$q_i-q_j\f$ and \f$q_k-q_j\f$, a torsion i-j-k-l to \f$q_j-q_i\f$,
+ *  \f$q_j-q_k\f$, and \f$q_k-q_l\f$, and an improper with central atom j to
+ *  \f$q_j-q_i\f$, \f$q_j-q_k\f$, and \f$q_j-q_l\f$.
+ */
+class BondRefs{
+    enum class Kind{ANGLE,TORSION,IMPTORSION};
+    Kind kind_=Kind::ANGLE;
+    size_t nbonds_=0;
+    std::vector<Index_t> refs_;
+public:
+    ///Refers to no coordinates
+    BondRefs()=default;
+
+    /** \brief Finds the bonds of each coordinate in \p coords
+     *
+     *  \param[in] type IntCoord_t::ANGLE, TORSION, or IMPTORSION
+     *  \param[in] coords The atoms of the coordinates
+     *  \param[in] bonds The atoms of the bonds of the system
+     *  \param[in] natoms The number of atoms in the system
+     *  \param[out] rv Set to the references if every pair of atoms a
+     *                 coordinate needs is a bond
+     *  \return False, leaving \p rv alone, if \p type isn't made of bonds or
+     *          some coordinate has a pair of atoms that isn't bonded
+     */
+    static bool find(const std::string& type,const AtomTuples& coords,
+                     const AtomTuples& bonds,size_t natoms,BondRefs& rv);
+
+    ///The number of coordinates
+    size_t size()const{return nbonds_?refs_.size()/nbonds_:0;}
+
+    /** \brief The value (\p order 0) or gradient (\p order 1) of coordinate
+     *         \p i from the bond vectors
+     *
+     *  \param[out] out Where the 1, or 3 per atom, elements go
+     */
+    void deriv(size_t order,const BondVectors& bonds,size_t i,
+               double* out)const;
+};
+
+} //End namespace FManII
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "ForceManII/Cell.hpp"
+#include "ForceManII/Common.hpp"
+#include "ForceManII/Util.hpp"
+#include <cmath>
+
+using namespace std;
+using DArray=std::array<double,3>;
+namespace FManII {
+
+//Determinant of a 3 by 3 row-major matrix
+inline double det(const array<double,9>& m){
+    return m[0]*(m[4]*m[8]-m[5]*m[7])-
+           m[1]*(m[3]*m[8]-m[5]*m[6])+
+           m[2]*(m[3]*m[7]-m[4]*m[6]);
+}
+
+Cell::Cell(double a,double b,double c):
+    Cell(array<double,9>({a,0.0,0.0,0.0,b,0.0,0.0,0.0,c})){}
+
+Cell::Cell(const array<double,9>& lattice):
+    lattice_(lattice),
+    ortho_(lattice[1]==0.0 && lattice[2]==0.0 && lattice[3]==0.0 &&
+           lattice[5]==0.0 && lattice[6]==0.0 && lattice[7]==0.0)
+{
+    const double d=det(lattice_);
+    CHECK(std::fabs(d)>0.0,"Lattice vectors are linearly dependent");
+    const array<double,9>& m=lattice_;
+    inverse_={(m[4]*m[8]-m[5]*m[7])/d,(m[2]*m[7]-m[1]*m[8])/d,
+              (m[1]*m[5]-m[2]*m[4])/d,(m[5]*m[6]-m[3]*m[8])/d,
+              (m[0]*m[8]-m[2]*m[6])/d,(m[2]*m[3]-m[0]*m[5])/d,
+              (m[3]*m[7]-m[4]*m[6])/d,(m[1]*m[6]-m[0]*m[7])/d,
+              (m[0]*m[4]-m[1]*m[3])/d};
+}
+
+double Cell::volume()const{return std::fabs(det(lattice_));}
+
+DArray Cell::to_frac(const DArray& r)const{
+    const array<double,9>& m=inverse_;
+    return {r[0]*m[0]+r[1]*m[3]+r[2]*m[6],
+            r[0]*m[1]+r[1]*m[4]+r[2]*m[7],
+            r[0]*m[2]+r[1]*m[5]+r[2]*m[8]};
+}
+
+DArray Cell::to_cart(const DArray& s)const{
+    const array<double,9>& m=lattice_;
+    return {s[0]*m[0]+s[1]*m[3]+s[2]*m[6],
+            s[0]*m[1]+s[1]*m[4]+s[2]*m[7],
+            s[0]*m[2]+s[1]*m[5]+s[2]*m[8]};
+}
+
+DArray Cell::minimum_image(const DArray& dr)const{
+    if(ortho_){
+        DArray rv(dr);
+        for(size_t i=0;i<3;++i)
+            rv[i]-=lattice_[i*4]*std::round(dr[i]*inverse_[i*4]);
+        return rv;
+    }
+    //Rounding in fractional coordinates is only exact for orthorhombic cells,
+    //for skewed cells the answer may be one of the neighboring images
+    DArray s=to_frac(dr);
+    for(double& si:s)si-=std::round(si);
+    DArray best=to_cart(s);
+    double best_r2=dot(best,best);
+    for(int i=-1;i<=1;++i)
+        for(int j=-1;j<=1;++j)
+            for(int k=-1;k<=1;++k){
+                const DArray r=to_cart({s[0]+i,s[1]+j,s[2]+k});
+                const double r2=dot(r,r);
+                if(r2<best_r2){best=r;best_r2=r2;}
+            }
+    return best;
+}
+
+Vector Cell::wrap(const Vector& carts)const{
+    Vector rv(carts.size());
+    for(size_t i=0;i<carts.size()/3;++i){
+        DArray s=to_frac({carts[3*i],carts[3*i+1],carts[3*i+2]});
+        for(double& si:s)si-=std::floor(si);
+        const DArray r=to_cart(s);
+        for(size_t j=0;j<3;++j)rv[3*i+j]=r[j];
+    }
+    return rv;
+}
+
+} //End namespace FManII
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+
+#include "ForceManII/FManIIDefs.hpp"
+#include <array>
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+
+/** \brief The unit cell of a periodic system
+ *
+ *  The cell is defined by three lattice vectors, stored as the rows of a 3 by
+ *  3 matrix, in a.u.  Orthorhombic cells (the lattice vectors lie along the
+ *  Cartesian axes) are detected and use a cheaper minimum image.
+ */
+class Cell{
+public:
+    ///Makes an orthorhombic cell with sides of length \p a, \p b, and \p c
+    Cell(double a,double b,double c);
+
+    ///Makes a triclinic cell, row i of \p lattice is the i-th lattice vector
+    Cell(const std::array<double,9>& lattice);
+
+    ///The lattice vectors, row-major
+    const std::array<double,9>& lattice()const{return lattice_;}
+
+    ///True if the lattice vectors are along the Cartesian axes
+    bool is_orthorhombic()const{return ortho_;}
+
+    ///The volume of the cell
+    double volume()const;
+
+    ///Returns the periodic image of \p dr with the smallest magnitude
+    std::array<double,3> minimum_image(const std::array<double,3>& dr)const;
+
+    ///Returns \p carts with each atom translated into the home cell
+    Vector wrap(const Vector& carts)const;
+
+    ///True if the two cells have the same lattice vectors
+    bool operator==(const Cell& other)const{return lattice_==other.lattice_;}
+
+    ///True if the cells have different lattice vectors
+    bool operator!=(const Cell& other)const{return !(*this==other);}
+
+private:
+    std::array<double,9> lattice_;///<Lattice vectors as rows
+    std::array<double,9> inverse_;///<Inverse of lattice_
+    bool ortho_;///<Is the cell orthorhombic?
+
+    ///Converts a Cartesian vector to fractional coordinates
+    std::array<double,3> to_frac(const std::array<double,3>& r)const;
+
+    ///Converts fractional coordinates to a Cartesian vector
+    std::array<double,3> to_cart(const std::array<double,3>& s)const;
+};
+
+} //End namespace FManII
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "ForceManII/Coloring.hpp"
+#include <algorithm>
+#include <cstdint>
+
+using namespace std;
+namespace FManII {
+
+Coloring::Coloring(const AtomTuples& tuples,size_t natoms){
+    const size_t n=tuples.size(),arity=tuples.arity();
+    //A coordinate shares atoms with at most arity*(max_uses-1) others, so
+    //one more color than that always suffices
+    vector<Index_t> uses(natoms,0);
+    for(Index_t ai:tuples.data()){
+        CHECK(ai<natoms,"Atom "+to_string(ai)+" does not exist");
+        ++uses[ai];
+    }
+    const size_t max_uses=n?*max_element(uses.begin(),uses.end()):0,
+                 nwords=(arity*(max_uses?max_uses-1:0)+64)/64;
+    //Bit c of an atom's words is set once a coordinate of color c uses it
+    vector<uint64_t> used(natoms*nwords,0);
+    vector<Index_t> colors(n);
+    size_t ncolors=0;
+    for(size_t i=0;i<n;++i){
+        const AtomTuple atoms=tuples[i];
+        size_t c=64*nwords;
+        for(size_t w=0;w<nwords && c==64*nwords;++w){
+            uint64_t taken=0;
+            for(size_t ai:atoms)taken|=used[ai*nwords+w];
+            if(taken==~uint64_t(0))continue;
+            size_t bit=0;
+            while(taken>>bit & 1)++bit;
+            c=64*w+bit;
+        }
+        DEBUG_CHECK(c<64*nwords,"Ran out of colors");
+        for(size_t ai:atoms)used[ai*nwords+c/64]|=uint64_t(1)<<(c%64);
+        colors[i]=static_cast<Index_t>(c);
+        ncolors=max(ncolors,c+1);
+    }
+    offsets_.assign(ncolors+1,0);
+    for(Index_t c:colors)++offsets_[c+1];
+    for(size_t c=0;c<ncolors;++c)offsets_[c+1]+=offsets_[c];
+    vector<Index_t> next(offsets_.begin(),offsets_.end()-1);
+    members_.resize(n);
+    for(size_t i=0;i<n;++i)members_[next[colors[i]]++]=static_cast<Index_t>(i);
+}
+
+} //End namespace FManII
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+#include "ForceManII/AtomTuples.hpp"
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+
+/** \brief Groups the coordinates of one type so that no two coordinates in a
+ *         group (a color) share an atom
+ *
+ *  The derivatives of the coordinates of one color go to different atoms, so
+ *  they can be added into a gradient from many threads without locks or
+ *  per-thread copies of the gradient.  Colors are found greedily, in the
+ *  order of the coordinates, and are stored in compressed form: the
+ *  coordinates of color c are elements offsets[c] up to offsets[c+1] of one
+ *  array, in increasing order.
+ */
+class Coloring{
+    std::vector<Index_t> offsets_,members_;
+public:
+    ///The coordinates of one color
+    struct Members{
+        const Index_t* first;
+        const Index_t* last;
+        const Index_t* begin()const{return first;}
+        const Index_t* end()const{return last;}
+        size_t size()const{return last-first;}
+        size_t operator[](size_t i)const{return first[i];}
+    };
+
+    ///Makes the coloring of no coordinates
+    Coloring():offsets_(1,0){}
+
+    ///Colors \p tuples, whose atoms must be less than \p natoms
+    Coloring(const AtomTuples& tuples,size_t natoms);
+
+    ///The number of colors
+    size_t ncolors()const{return offsets_.size()-1;}
+
+    ///The number of coordinates colored
+    size_t size()const{return members_.size();}
+
+    ///The coordinates with color \p c
+    Members color(size_t c)const{
+        return {members_.data()+offsets_[c],members_.data()+offsets_[c+1]};
+    }
+};
+
+} //End namespace FManII
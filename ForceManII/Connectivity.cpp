@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "ForceManII/Connectivity.hpp"
+#include "ForceManII/Common.hpp"
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+namespace FManII {
+
+Connectivity::Connectivity(const ConnData& conns){
+    const size_t natoms=conns.size();
+    CHECK(natoms<numeric_limits<Index_t>::max(),
+          "Too many atoms for 32-bit atom numbers");
+    offsets_.reserve(natoms+1);
+    offsets_.push_back(0);
+    size_t nbonded=0;
+    for(const auto& ci:conns)nbonded+=ci.size();
+    bonded_.reserve(nbonded);
+    for(size_t i=0;i<natoms;++i){
+        for(size_t j:conns[i]){
+            CHECK(j<natoms,"Atom "+to_string(i)+" is bonded to atom "+
+                  to_string(j)+", which does not exist");
+            DEBUG_CHECK(conns[j].count(i),"Atom "+to_string(i)+" is bonded to "+
+                        to_string(j)+" but not the other way");
+            bonded_.push_back(static_cast<Index_t>(j));
+        }
+        offsets_.push_back(static_cast<Index_t>(bonded_.size()));
+    }
+}
+
+bool Connectivity::bonded(size_t i,size_t j)const{
+    const Neighbors ns=neighbors(i);
+    return binary_search(ns.begin(),ns.end(),static_cast<Index_t>(j));
+}
+
+} //End namespace FManII
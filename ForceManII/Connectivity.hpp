@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+#include "ForceManII/FManIIDefs.hpp"
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+
+/** \brief The bonds of a system in compressed sparse row (CSR) form
+ *
+ *  The atoms bonded to atom i are elements offsets[i] up to offsets[i+1] of
+ *  one array, sorted.  Compared to ConnData, which has a std::set (a tree
+ *  node per bond) for every atom, this is two arrays of 4-byte indices.
+ */
+class Connectivity{
+    std::vector<Index_t> offsets_,bonded_;
+public:
+    ///The atoms bonded to one atom
+    struct Neighbors{
+        const Index_t* first;
+        const Index_t* last;
+        const Index_t* begin()const{return first;}
+        const Index_t* end()const{return last;}
+        size_t size()const{return last-first;}
+    };
+
+    ///Makes the connectivity of a system with no atoms
+    Connectivity():offsets_(1,0){}
+
+    ///Converts from the set-based form
+    explicit Connectivity(const ConnData& conns);
+
+    ///The number of atoms
+    size_t size()const{return offsets_.size()-1;}
+
+    ///The atoms bonded to atom \p i, in increasing order
+    Neighbors neighbors(size_t i)const{
+        return {bonded_.data()+offsets_[i],bonded_.data()+offsets_[i+1]};
+    }
+
+    ///True if atoms \p i and \p j are bonded
+    bool bonded(size_t i,size_t j)const;
+};
+
+} //End namespace FManII
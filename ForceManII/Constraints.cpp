@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "ForceManII/Constraints.hpp"
+#include "ForceManII/Cell.hpp"
+#include "ForceManII/Common.hpp"
+#include "ForceManII/Elements.hpp"
+#include "ForceManII/Util.hpp"
+#include <cmath>
+
+using namespace std;
+namespace FManII {
+
+//The vector from atom j to atom i
+inline array<double,3> bond_vector(const Vector& carts,size_t i,size_t j,
+                                   const Cell* cell){
+    const array<double,3> dr=diff(&carts[3*i],&carts[3*j]);
+    return cell?cell->minimum_image(dr):dr;
+}
+
+BondConstraints::BondConstraints(const Molecule& mol,const ParamSet& ps,
+                                 const Vector& masses,bool h_only,double tol,
+                                 size_t max_iters):
+    cell_(mol.cell),tol_(tol),max_iters_(max_iters)
+{
+    CHECK(tol>0.0 && max_iters>0,"Constraint tolerance must be positive");
+    auto bonds=mol.atom_numbers.find(IntCoord_t::BOND);
+    if(bonds==mol.atom_numbers.end() || !bonds->second.size())return;
+    CHECK(ps.count(Terms_t::HO_BOND),
+          "Constraints need the bond lengths of a harmonic bond term");
+    const Vector& r0=ps.at(Terms_t::HO_BOND).at(Param_t::r0);
+    CHECK(r0.size()==bonds->second.size(),"Need one length per bond");
+    const double light=4.0*amu2au;
+    for(size_t i=0;i<r0.size();++i){
+        const AtomTuple bond=bonds->second[i];
+        const size_t a=bond[0],b=bond[1];
+        CHECK(a<masses.size() && b<masses.size(),"Need one mass per atom");
+        if(h_only && masses[a]>=light && masses[b]>=light)continue;
+        if(r0[i]<=0.0)continue;//No parameters, nothing to hold it at
+        atoms_.insert(atoms_.end(),{a,b});
+        r0_.push_back(r0[i]);
+    }
+    for(double m:masses){
+        CHECK(m>0.0,"Constrained atoms need mass");
+        inv_m_.push_back(1.0/m);
+    }
+}
+
+void BondConstraints::shake(const Vector& old,Vector& carts,Vector* v,
+                            double dt)const{
+    CHECK(!v || dt>0.0,"Need the time step to correct velocities");
+    const Cell* cell=cell_.get();
+    for(size_t iter=0;iter<max_iters_;++iter){
+        bool done=true;
+        for(size_t c=0;c<r0_.size();++c){
+            const size_t i=atoms_[2*c],j=atoms_[2*c+1];
+            const array<double,3> r=bond_vector(carts,i,j,cell);
+            const double d2=r0_[c]*r0_[c],err=dot(r,r)-d2;
+            if(std::fabs(err)<=2.0*tol_*d2)continue;
+            done=false;
+            const array<double,3> ref=bond_vector(old,i,j,cell);
+            const double g=err/(2.0*dot(r,ref)*(inv_m_[i]+inv_m_[j]));
+            for(size_t x=0;x<3;++x){
+                carts[3*i+x]-=g*inv_m_[i]*ref[x];
+                carts[3*j+x]+=g*inv_m_[j]*ref[x];
+                if(!v)continue;
+                (*v)[3*i+x]-=g*inv_m_[i]*ref[x]/dt;
+                (*v)[3*j+x]+=g*inv_m_[j]*ref[x]/dt;
+            }
+        }
+        if(done)return;
+    }
+    CHECK(false,"SHAKE did not converge");
+}
+
+void BondConstraints::rattle(const Vector& carts,Vector& v)const{
+    const Cell* cell=cell_.get();
+    for(size_t iter=0;iter<max_iters_;++iter){
+        bool done=true;
+        for(size_t c=0;c<r0_.size();++c){
+            const size_t i=atoms_[2*c],j=atoms_[2*c+1];
+            const array<double,3> r=bond_vector(carts,i,j,cell),
+                                  dv=diff(&v[3*i],&v[3*j]);
+            const double d2=r0_[c]*r0_[c],rv=dot(r,dv);
+            if(std::fabs(rv)<=tol_*d2*std::sqrt(dot(dv,dv))/r0_[c])continue;
+            done=false;
+            const double k=rv/(d2*(inv_m_[i]+inv_m_[j]));
+            for(size_t x=0;x<3;++x){
+                v[3*i+x]-=k*inv_m_[i]*r[x];
+                v[3*j+x]+=k*inv_m_[j]*r[x];
+            }
+        }
+        if(done)return;
+    }
+    CHECK(false,"RATTLE did not converge");
+}
+
+} //End namespace FManII
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+#include "ForceManII/FManIIDefs.hpp"
+#include <array>
+#include <memory>
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+class Cell;
+
+/** \brief Holds bond lengths fixed with SHAKE and RATTLE
+ *
+ *  The constrained bonds are the BOND coordinates of a Molecule, held at the
+ *  r0 of the force field's HO_BOND term.  Bonds without parameters (r0 left
+ *  at zero by assign_params' skip_missing) aren't constrained.  Both solvers go over the bonds
+ *  one at a time until every bond is within the tolerance, correcting each
+ *  pair of atoms along the bond in proportion to their inverse masses.
+ *
+ *  Atoms are numbered as in the Molecule the constraints were made from.
+ */
+class BondConstraints{
+public:
+    BondConstraints()=default;
+
+    /** \brief Picks the bonds to constrain
+     *
+     *  \param[in] masses The mass of each atom, in a.u.
+     *  \param[in] h_only If true only bonds to atoms lighter than 4 amu (H, D,
+     *                    and T) are constrained
+     *  \param[in] tol Largest relative error allowed in a bond length (and in
+     *                 the velocity along it)
+     *  \throws std::runtime_error if the molecule has bonds but the parameters
+     *          have no HO_BOND term
+     */
+    BondConstraints(const Molecule& mol,const ParamSet& ps,const Vector& masses,
+                    bool h_only,double tol=1e-10,size_t max_iters=1000);
+
+    size_t size()const{return r0_.size();}///<Number of constrained bonds
+    bool empty()const{return r0_.empty();}///<True if nothing is constrained
+
+    ///The atoms of constraint \p i
+    std::array<size_t,2> atoms(size_t i)const{
+        return {{atoms_[2*i],atoms_[2*i+1]}};
+    }
+    double length(size_t i)const{return r0_[i];}///<Length of constraint i
+
+    /** \brief SHAKE: moves \p carts back onto the constraints
+     *
+     *  The corrections are along the bonds of \p old, which must satisfy the
+     *  constraints.  If \p v isn't null, it is corrected by the displacement
+     *  divided by \p dt, the time taken to go from \p old to \p carts.
+     *
+     *  \throws std::runtime_error if it doesn't converge
+     */
+    void shake(const Vector& old,Vector& carts,Vector* v=nullptr,
+               double dt=0.0)const;
+
+    ///RATTLE: removes the velocity along each bond of \p carts from \p v
+    void rattle(const Vector& carts,Vector& v)const;
+
+private:
+    IVector atoms_;///<The two atoms of each constraint
+    Vector r0_,inv_m_;///<Bond lengths and inverse masses of the atoms
+    std::shared_ptr<const Cell> cell_;
+    double tol_=1e-10;
+    size_t max_iters_=1000;
+};
+
+} //End namespace FManII
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "ForceManII/Elements.hpp"
+#include "ForceManII/Common.hpp"
+#include <array>
+
+using namespace std;
+namespace FManII {
+
+static const array<const char*,55> symbols={{"",
+    "H","He","Li","Be","B","C","N","O","F","Ne",
+    "Na","Mg","Al","Si","P","S","Cl","Ar","K","Ca",
+    "Sc","Ti","V","Cr","Mn","Fe","Co","Ni","Cu","Zn",
+    "Ga","Ge","As","Se","Br","Kr","Rb","Sr","Y","Zr",
+    "Nb","Mo","Tc","Ru","Rh","Pd","Ag","Cd","In","Sn",
+    "Sb","Te","I","Xe"}};
+
+//IUPAC standard atomic weights, the longest-lived isotope for Tc
+static const array<double,55> masses={{0.0,
+    1.008,4.002602,6.94,9.0121831,10.81,12.011,14.007,15.999,18.998403163,
+    20.1797,22.98976928,24.305,26.9815385,28.085,30.973761998,32.06,35.45,
+    39.948,39.0983,40.078,44.955908,47.867,50.9415,51.9961,54.938044,55.845,
+    58.933194,58.6934,63.546,65.38,69.723,72.630,74.921595,78.971,79.904,
+    83.798,85.4678,87.62,88.90584,91.224,92.90637,95.95,97.0,101.07,
+    102.90550,106.42,107.8682,112.414,114.818,118.710,121.760,127.60,
+    126.90447,131.293}};
+
+double atomic_mass(size_t Z){
+    CHECK(Z>0 && Z<masses.size(),"No mass for element "+to_string(Z));
+    return masses[Z];
+}
+
+size_t atomic_number(const string& symbol){
+    for(size_t Z=1;Z<symbols.size();++Z)
+        if(symbol==symbols[Z])return Z;
+    throw runtime_error(symbol+" is not a known element");
+}
+
+Vector atom_masses(const IVector& atomic_numbers){
+    Vector rv;
+    rv.reserve(atomic_numbers.size());
+    for(size_t Z:atomic_numbers)rv.push_back(atomic_mass(Z)*amu2au);
+    return rv;
+}
+
+} //End namespace FManII
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+#include "ForceManII/FManIIDefs.hpp"
+#include <string>
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+
+///Atomic mass units to atomic units (electron masses)
+constexpr double amu2au=1822.888486;
+
+/** \brief The standard atomic weight of element \p Z, in atomic mass units
+ *
+ *  Elements 1 (H) through 54 (Xe) are known.
+ */
+double atomic_mass(size_t Z);
+
+///The atomic number of the element with symbol \p symbol (e.g. "C", "Cl")
+size_t atomic_number(const std::string& symbol);
+
+///The mass of each atom in atomic units (not amu), given its atomic number
+Vector atom_masses(const IVector& atomic_numbers);
+
+} //End namespace FManII
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "ForceManII/EvaluationPlan.hpp"
+#include "ForceManII/Common.hpp"
+#include "ForceManII/FManII.hpp"
+#include "ForceManII/Parallel.hpp"
+#include <algorithm>
+#include <memory>
+
+using namespace std;
+namespace FManII {
+
+//Reorders blocks of \p stride elements, block i of the result is block
+//\p perm[i] of \p v
+inline Vector permute(const Vector& v,const IVector& perm,size_t stride){
+    Vector rv(v.size());
+    for(size_t i=0;i<perm.size();++i)
+        for(size_t x=0;x<stride;++x)rv[stride*i+x]=v[stride*perm[i]+x];
+    return rv;
+}
+
+EvaluationPlan::EvaluationPlan(const Vector& carts,
+                               const ConnData& conns,
+                               const ForceField& ff,
+                               const IVector& types,
+                               const Cell* cell,
+                               AtomOrder order,
+                               bool skip_missing,
+                               const TermFilter& filter):
+    ff_(ff),natoms_(carts.size()/3)
+{
+    CHECK(conns.size()==natoms_ && types.size()==natoms_,
+          "Number of atoms differs among inputs");
+    //Coordinates are found in the caller's numbering so each keeps its atoms
+    //in the same order (which e.g. impropers depend on)
+    const set<string> needed=coords_needed(ff_,filter);
+    mol_=get_coords(carts,conns,cell,filter?&needed:nullptr);
+    ps_=assign_params(mol_,ff_,types,skip_missing,filter);
+    if(order==AtomOrder::INPUT)return;
+
+    //Renumber the atoms, then sort each type of coordinate by its new atoms
+    //so neighboring coordinates touch neighboring memory
+    order_=curve_order(carts,order);
+    IVector new_number(natoms_);
+    for(size_t i=0;i<natoms_;++i)new_number[order_[i]]=i;
+    mol_.carts=std::make_shared<Vector>(to_internal(carts));
+    for(auto& ci:mol_.atom_numbers){
+        const AtomTuples& old_atoms=ci.second;
+        const size_t n=old_atoms.size(),arity=old_atoms.arity();
+        vector<Index_t> relabeled(old_atoms.data());
+        for(Index_t& ai:relabeled)ai=static_cast<Index_t>(new_number[ai]);
+        IVector perm(n);
+        for(size_t i=0;i<n;++i)perm[i]=i;
+        const Index_t* atoms=relabeled.data();
+        stable_sort(perm.begin(),perm.end(),[&](size_t i,size_t j){
+            return lexicographical_compare(atoms+i*arity,atoms+(i+1)*arity,
+                                           atoms+j*arity,atoms+(j+1)*arity);
+        });
+        AtomTuples new_atoms(arity);
+        new_atoms.reserve(n);
+        for(size_t i:perm)new_atoms.push_back(AtomTuple(atoms+i*arity,arity));
+        ci.second=move(new_atoms);
+        Vector& values=mol_.coords.at(ci.first);
+        values=permute(values,perm,1);
+        for(auto& pi:ps_){
+            if(pi.first.second!=ci.first)continue;
+            for(auto& param:pi.second){
+                CHECK(n && param.second.size()%n==0,"Can't reorder "+
+                      param.first+" of "+pi.first.first+" "+pi.first.second);
+                param.second=permute(param.second,perm,param.second.size()/n);
+            }
+        }
+    }
+    color_coords(mol_);
+    index_bonds(mol_);
+}
+
+Vector EvaluationPlan::to_internal(const Vector& v)const{
+    CHECK(v.size()==3*natoms_,"Expected 3 elements per atom");
+    if(order_.empty())return v;
+    Vector rv(v.size());
+    for(size_t i=0;i<natoms_;++i)
+        for(size_t x=0;x<3;++x)rv[3*i+x]=v[3*order_[i]+x];
+    return rv;
+}
+
+Vector EvaluationPlan::from_internal(const Vector& v)const{
+    CHECK(v.size()==3*natoms_,"Expected 3 elements per atom");
+    if(order_.empty())return v;
+    Vector rv(v.size());
+    for(size_t i=0;i<natoms_;++i)
+        for(size_t x=0;x<3;++x)rv[3*order_[i]+x]=v[3*i+x];
+    return rv;
+}
+
+void EvaluationPlan::set_coords(const Vector& carts){
+    update_coords(mol_,to_internal(carts));
+}
+
+DerivType EvaluationPlan::deriv(size_t order)const{
+    DerivType rv=FManII::deriv(order,ff_,ps_,mol_);
+    if(order==1 && !order_.empty())
+        for(auto& di:rv)di.second=from_internal(di.second);
+    return rv;
+}
+
+EnergyType EvaluationPlan::energy(const Vector& carts)const{
+    if(order_.empty())return FManII::energy(ff_,ps_,mol_,nullptr,&carts);
+    const Vector internal=to_internal(carts);
+    return FManII::energy(ff_,ps_,mol_,nullptr,&internal);
+}
+
+void EvaluationPlan::add_gradient(Vector& grad,EnergyType* energies)const{
+    if(order_.empty()){
+        FManII::add_gradient(ff_,ps_,mol_,grad,energies);
+        return;
+    }
+    Vector internal=to_internal(grad);
+    FManII::add_gradient(ff_,ps_,mol_,internal,energies);
+    for(size_t i=0;i<natoms_;++i)
+        for(size_t x=0;x<3;++x)grad[3*order_[i]+x]=internal[3*i+x];
+}
+
+Vector EvaluationPlan::batch(const Vector& frames,Vector* grads,
+                             vector<EnergyType>* energies)const{
+    const size_t n=3*natoms_;
+    CHECK(n && frames.size()%n==0,"Frames need 3 elements per atom");
+    const size_t nframes=frames.size()/n;
+    Vector rv(nframes,0.0);
+    if(grads)grads->assign(frames.size(),0.0);
+    if(energies)energies->assign(nframes,EnergyType());
+    parallel_for(nframes,[&](size_t,size_t begin,size_t end){
+        SerialRegion serial;
+        //Only gradients need the values of the coordinates
+        unique_ptr<Molecule> mol(grads?new Molecule(mol_):nullptr);
+        Vector carts(n),grad(grads?n:0);
+        EnergyType egys;
+        for(size_t f=begin;f<end;++f){
+            copy(frames.begin()+f*n,frames.begin()+(f+1)*n,carts.begin());
+            if(grads){
+                update_coords(*mol,to_internal(carts));
+                fill(grad.begin(),grad.end(),0.0);
+                FManII::add_gradient(ff_,ps_,*mol,grad,&egys);
+                double* out=grads->data()+f*n;
+                for(size_t i=0;i<natoms_;++i)
+                    for(size_t x=0;x<3;++x)
+                        out[3*(order_.empty()?i:order_[i])+x]=grad[3*i+x];
+            }
+            else egys=energy(carts);
+            for(const auto& ei:egys)rv[f]+=ei.second;
+            if(energies)(*energies)[f]=egys;
+        }
+    });
+    return rv;
+}
+
+} //End namespace FManII
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+#include "ForceManII/AtomOrder.hpp"
+#include "ForceManII/Cell.hpp"
+#include "ForceManII/ForceField.hpp"
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+
+/** \brief Everything about a system that doesn't change when its atoms move
+ *
+ *  get_coords() finds the internal coordinates and assign_params() their
+ *  parameters once, when the plan is made.  After that only the values of the
+ *  internal coordinates are recomputed for each new geometry, so repeated
+ *  calls (optimizations, dynamics, rescoring) skip the setup.
+ *
+ *  Internally the atoms may be renumbered (see AtomOrder) so that atoms close
+ *  in space are close in memory, which helps the caches when the derivatives
+ *  are scattered onto the atoms.  Cartesian coordinates passed in and
+ *  derivatives returned always use the caller's numbering.
+ */
+class EvaluationPlan{
+public:
+    /** \brief Finds the internal coordinates and parameters of a system
+     *
+     *  \param[in] carts The Cartesian coordinates, in a.u.
+     *  \param[in] conns The bonds, as for get_coords()
+     *  \param[in] ff The force field, it is copied
+     *  \param[in] types The atom type of each atom
+     *  \param[in] cell The unit cell if the system is periodic
+     *  \param[in] order How to number the atoms internally
+     *  \param[in] skip_missing As for assign_params()
+     *  \param[in] filter Only the terms it keeps are set up and computed
+     */
+    EvaluationPlan(const Vector& carts,
+                   const ConnData& conns,
+                   const ForceField& ff,
+                   const IVector& types,
+                   const Cell* cell=nullptr,
+                   AtomOrder order=AtomOrder::INPUT,
+                   bool skip_missing=true,
+                   const TermFilter& filter=nullptr);
+
+    ///The number of atoms
+    size_t natoms()const{return natoms_;}
+
+    ///Moves the atoms to \p carts (caller's numbering, a.u.)
+    void set_coords(const Vector& carts);
+
+    ///The derivatives at the current geometry, keyed like deriv()'s
+    DerivType deriv(size_t order)const;
+
+    ///Moves the atoms to \p carts and returns the derivatives there
+    DerivType deriv(size_t order,const Vector& carts){
+        set_coords(carts);
+        return deriv(order);
+    }
+
+    ///The energy of each term at \p carts (caller's numbering), without
+    ///moving the plan, see FManII::energy()
+    EnergyType energy(const Vector& carts)const;
+
+    ///Adds the gradient at the current geometry to \p grad (caller's
+    ///numbering), optionally setting the energy of each term, see
+    ///FManII::add_gradient()
+    void add_gradient(Vector& grad,EnergyType* energies=nullptr)const;
+
+    ///Moves the atoms to \p carts and adds the gradient there to \p grad
+    void add_gradient(const Vector& carts,Vector& grad,
+                      EnergyType* energies=nullptr){
+        set_coords(carts);
+        add_gradient(grad,energies);
+    }
+
+    /** \brief The energies, and optionally gradients, of many geometries of
+     *         the system
+     *
+     *  Each thread takes a contiguous block of frames and evaluates them one
+     *  after another on its own copy of the internal coordinates, so a frame
+     *  gives the same result however many threads there are.  The plan's
+     *  current geometry is not changed.
+     *
+     *  \param[in] frames The geometries one after another, 3*natoms()
+     *                    elements each (caller's numbering, a.u.)
+     *  \param[out] grads If not null, set to the gradient of each frame, laid
+     *                    out like \p frames
+     *  \param[out] energies If not null, set to the energy of each term of
+     *                       each frame
+     *  \return The total energy of each frame
+     */
+    Vector batch(const Vector& frames,Vector* grads=nullptr,
+                 std::vector<EnergyType>* energies=nullptr)const;
+
+    ///The force field the plan uses
+    const ForceField& force_field()const{return ff_;}
+
+    ///The internal coordinates, atoms are in the internal numbering
+    const Molecule& molecule()const{return mol_;}
+
+    ///The parameters of each term
+    const ParamSet& params()const{return ps_;}
+
+    ///Element i is the caller's number of internal atom i, empty if the atoms
+    ///were not renumbered
+    const IVector& atom_order()const{return order_;}
+
+    ///Renumbers a vector with 3 elements per atom from the caller's order to
+    ///the internal order
+    Vector to_internal(const Vector& v)const;
+
+    ///Renumbers a vector with 3 elements per atom from the internal order to
+    ///the caller's order
+    Vector from_internal(const Vector& v)const;
+
+private:
+    ForceField ff_;
+    size_t natoms_;
+    IVector order_;
+    Molecule mol_;
+    ParamSet ps_;
+};
+
+} //End namespace FManII
@@ -1,25 +1,72 @@
 #include "ForceManII/FFTerm.hpp"
 #include "ForceManII/Common.hpp"
+#include "ForceManII/Parallel.hpp"
+#include <algorithm>
 
 using namespace std;
 namespace FManII {
 
-const Vector d1(const Vector& Carts,
-                const vector<IVector>& ans,
-                const InternalCoordinates& coord,
-                const Vector& dm)
+//Coordinates per thread below which a color is not worth splitting up
+constexpr size_t min_coords_per_chunk=256;
+
+//Adds scale times the chain rule of dm, the derivative of the model with
+//respect to each coordinate, and the coordinates' gradients to deriv
+void d1(const Vector& Carts,
+        const AtomTuples& ans,
+        const InternalCoordinates& coord,
+        const Vector& dm,
+        double scale,
+        const Cell* cell,
+        const Coloring* colors,
+        const BondRefs* refs,
+        const BondVectors& bonds,
+        double* deriv)
 {
     DEBUG_CHECK(ans.size()==dm.size(),"Derivative sizes are incompatible");
-    Vector deriv(Carts.size());
-    for(size_t coordi=0;coordi<ans.size();++coordi)
-    {
-        const IVector atoms=ans[coordi];
-        const Vector dc=coord.deriv(1,Carts,atoms);
+    CHECK(!refs || refs->size()==ans.size(),"Bonds of "+coord.name+
+          " are out of date, see index_bonds()");
+    auto add=[&](size_t coordi){
+        const AtomTuple atoms=ans[coordi];
+        std::array<double,3*max_arity> buffer;
+        Vector generic;
+        const double* dc=buffer.data();
+        if(refs)refs->deriv(1,bonds,coordi,buffer.data());
+        else{
+            generic=coord.deriv(1,Carts,atoms,cell);
+            dc=generic.data();
+        }
+        const double dmi=scale*dm[coordi];
         for(size_t i=0;i<atoms.size();++i)
             for(size_t j=0;j<3;++j)
-                deriv[atoms[i]*3+j]+=dm[coordi]*dc[i*3+j];
+                deriv[atoms[i]*3+j]+=dmi*dc[i*3+j];
+    };
+    if(!colors){
+        for(size_t coordi=0;coordi<ans.size();++coordi)add(coordi);
+        return;
+    }
+    CHECK(colors->size()==ans.size(),"Coloring is out of date, see "
+          "color_coords()");
+    //Coordinates of one color touch different atoms, so threads can add
+    //them straight into deriv
+    for(size_t c=0;c<colors->ncolors();++c){
+        const Coloring::Members members=colors->color(c);
+        const size_t nchunks=
+            std::max<size_t>(members.size()/min_coords_per_chunk,1);
+        parallel_for(members.size(),std::min(nchunks,get_num_threads()),
+                     [&](size_t,size_t begin,size_t end){
+            for(size_t i=begin;i<end;++i)add(members[i]);
+        });
     }
-    return deriv;
+}
+
+void FFTerm::d1(const Vector& dm,const Molecule& cs,double scale,
+                double* grad)const{
+    const auto colors=cs.colors.find(coord_->name);
+    const auto refs=cs.bond_refs.find(coord_->name);
+    FManII::d1(*cs.carts,cs.atom_numbers.at(coord_->name),*coord_,dm,scale,
+               cs.cell.get(),colors==cs.colors.end()?nullptr:&colors->second,
+               refs==cs.bond_refs.end()?nullptr:&refs->second,cs.bond_vectors,
+               grad);
 }
 
 Vector FFTerm::deriv(size_t order,const map<string,Vector>& ps,
@@ -29,7 +76,15 @@ Vector FFTerm::deriv(size_t order,const map<string,Vector>& ps,
     incoords.push_back(cs.coords.at(coord_->name));
     const Vector dm=model_->deriv(order,ps,incoords);
     if(order==0)return dm;
-    const Vector dc1=d1(*cs.carts,cs.atom_numbers.at(coord_->name),*coord_,dm);
-    if(order==1)return dc1;
+    Vector dc1(cs.carts->size(),0.0);
+    d1(dm,cs,1.0,dc1.data());
+    return dc1;
+}
+
+void FFTerm::add_gradient(const map<string,Vector>& ps,const Molecule& cs,
+                          double scale,double* grad,double* energy)const{
+    const vector<Vector> incoords(1,cs.coords.at(coord_->name));
+    if(energy)*energy=scale*model_->deriv(0,ps,incoords)[0];
+    d1(model_->deriv(1,ps,incoords),cs,scale,grad);
 }
 }
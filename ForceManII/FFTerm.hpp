@@ -27,6 +27,9 @@ namespace FManII {
 class FFTerm{
     std::shared_ptr<const ModelPotential> model_;///< The model to use
     std::shared_ptr<const InternalCoordinates> coord_;///<The coordinate
+
+    ///Adds \p scale times the gradient given the model's first derivative
+    void d1(const Vector& dm,const Molecule& cs,double scale,double* grad)const;
 public:
     ///Makes a new FF term given the model and coordinates it depends on
     FFTerm(std::shared_ptr<const ModelPotential> m,
@@ -47,6 +50,17 @@ public:
     Vector deriv(size_t order,const std::map<std::string,Vector>& ps,
                               const Molecule& cs)const;
 
+    /** \brief Adds \p scale times the gradient of this term to \p grad
+     *
+     *  \param[in,out] grad 3 elements per atom of \p cs
+     *  \param[out] energy If not null, set to \p scale times the energy
+     */
+    void add_gradient(const std::map<std::string,Vector>& ps,
+                      const Molecule& cs,
+                      double scale,
+                      double* grad,
+                      double* energy=nullptr)const;
+
     ///True if both terms have the same model and type of coordinates
     bool operator==(const FFTerm& other)const{
         return(*model_==*other.model_ &&
@@ -18,6 +18,9 @@
  */
 #include "ForceManII/FManII.hpp"
 #include "ForceManII/Common.hpp"
+#include "ForceManII/Nonbonded.hpp"
+#include "ForceManII/Parallel.hpp"
+#include "ForceManII/Profile.hpp"
 #include "ForceManII/Util.hpp"
 #include "ForceManII/InternalCoords/Distance.hpp"
 #include "ForceManII/InternalCoords/Angle.hpp"
@@ -25,6 +28,7 @@
 #include "ForceManII/InternalCoords/ImproperTorsion.hpp"
 #include <iostream>
 #include <algorithm>
+#include <tuple>
 
 using namespace std;
 namespace FManII {
@@ -37,110 +41,539 @@ const ForceField& get_ff(const string& name)
     throw runtime_error("Unrecognized hard-coded force field requested.");
 }
 
+//Number of internal coordinates in a system
+inline size_t ncoords(const Molecule& mol){
+    size_t n=0;
+    for(const auto& ci:mol.atom_numbers)n+=ci.second.size();
+    return n;
+}
+
+//Bytes used to store a system's internal coordinates
+inline size_t nbytes(const Molecule& mol){
+    size_t n=0;
+    for(const auto& ci:mol.coords)n+=detail::bytes_of(ci.second);
+    for(const auto& ci:mol.atom_numbers)n+=detail::bytes_of(ci.second.data());
+    return n;
+}
+
+//Bytes used to store the parameters of one term
+inline size_t nbytes(const map<string,Vector>& ps){
+    size_t n=0;
+    for(const auto& pi:ps)n+=detail::bytes_of(pi.second);
+    return n;
+}
+
+//Bytes used to store the parameters of a system
+inline size_t nbytes(const ParamSet& ps){
+    size_t n=0;
+    for(const auto& pi:ps)n+=nbytes(pi.second);
+    return n;
+}
+
+//Bytes used to store derivatives
+inline size_t nbytes(const DerivType& ds){
+    size_t n=0;
+    for(const auto& di:ds)n+=detail::bytes_of(di.second);
+    return n;
+}
+
+//Number of internal coordinates a set of parameters applies to
+inline size_t ncoords(const Molecule& mol,const ParamSet& ps){
+    size_t n=0;
+    for(const auto& pi:ps)n+=mol.atom_numbers.at(pi.first.second).size();
+    return n;
+}
+
 inline void add_coord(Molecule& FoundCoords,
                       const std::string& name,
-                      const IVector& atoms)
+                      const AtomTuple& atoms)
 {
     FoundCoords.atom_numbers[name].push_back(atoms);
-    const double value=get_intcoord(name)->deriv(0,*FoundCoords.carts,atoms)[0];
+    const double value=get_intcoord(name)->deriv(0,*FoundCoords.carts,atoms,
+                                                 FoundCoords.cell.get())[0];
     FoundCoords.coords[name].push_back(value);
 }
 
 
+//A pair of bonded atoms, or atoms separated by one or two others, i<j.  Kinds
+//are ordered so that sorting puts the closest relationship of a pair first.
+struct ExcludedPair{
+    enum Kind:unsigned char{PAIR12,PAIR13,PAIR14};
+    Index_t i,j;
+    Kind kind;
+    bool operator<(const ExcludedPair& other)const{
+        return std::tie(i,j,kind)<std::tie(other.i,other.j,other.kind);
+    }
+};
+
+TermFilter skip_terms(const vector<string>& models,
+                      const vector<string>& coords){
+    return [=](const FFTerm_t& term){
+        return find(models.begin(),models.end(),term.first)==models.end() &&
+               find(coords.begin(),coords.end(),term.second)==coords.end();
+    };
+}
+
+TermFilter only_term(const FFTerm_t& term){
+    return [=](const FFTerm_t& other){return other==term;};
+}
+
+set<string> coords_needed(const ForceField& ff,const TermFilter& filter){
+    set<string> rv;
+    for(const auto& ti:ff.terms)
+        if(!filter || filter(ti.first))rv.insert(ti.first.second);
+    return rv;
+}
+
 Molecule get_coords(const Vector& Carts,
-                      const ConnData& Conns){
+                      const ConnData& Conns,
+                      const Cell* cell,
+                      const set<string>* coord_types){
+    return get_coords(Carts,Connectivity(Conns),cell,coord_types);
+}
+
+Molecule get_coords(const Vector& Carts,
+                      const Connectivity& Conns,
+                      const Cell* cell,
+                      const set<string>* coord_types){
+    FMANII_TIMER(timer);
+    auto wanted=[&](const char* type){
+        return !coord_types || coord_types->count(type);
+    };
+    const bool want_bond=wanted(IntCoord_t::BOND),
+               want_pair13=wanted(IntCoord_t::PAIR13),
+               want_angle=wanted(IntCoord_t::ANGLE),
+               want_torsion=wanted(IntCoord_t::TORSION),
+               want_imp=wanted(IntCoord_t::IMPTORSION),
+               want_pair=wanted(IntCoord_t::PAIR),
+               want_pair14=wanted(IntCoord_t::PAIR14);
     const size_t NAtoms=Carts.size()/3;
     DEBUG_CHECK(NAtoms==Conns.size(),"Number of atoms differs among inputs");
     auto Sys=std::make_shared<Vector>(Carts);
     
     Molecule FoundCoords;
     FoundCoords.carts=Sys;
-    std::set<std::pair<size_t,size_t>> pair14,pair13,pair12;
+    if(cell)FoundCoords.cell=std::make_shared<Cell>(*cell);
+    vector<ExcludedPair> excluded;
     for(size_t AtomI=0;AtomI<NAtoms;++AtomI){
-        for(size_t AtomJ : Conns[AtomI]){
+        for(size_t AtomJ : Conns.neighbors(AtomI)){
             DEBUG_CHECK(AtomI!=AtomJ,"AtomI is bonded to itself. What??");
-            for(size_t AtomK: Conns[AtomJ]){
+            for(size_t AtomK: Conns.neighbors(AtomJ)){
                 DEBUG_CHECK(AtomK!=AtomJ,"Atom J is bonded to itself. What??");
                 if(AtomK==AtomI)continue;//Went backwards in the graph
-                for(size_t AtomL : Conns[AtomK]){
+                for(size_t AtomL : Conns.neighbors(AtomK)){
                     DEBUG_CHECK(AtomL!=AtomK,"Atom K is bonded to itself");
                     if(AtomL==AtomJ)continue;//Went backwards
-                    if(AtomL>AtomI){
-                        pair14.insert(std::make_pair(AtomI,AtomL));
-                    }
-                    if(AtomK<AtomJ)continue;
+                    if(AtomL>AtomI)
+                        excluded.push_back({Index_t(AtomI),Index_t(AtomL),
+                                            ExcludedPair::PAIR14});
+                    if(AtomK<AtomJ || !want_torsion)continue;
                     add_coord(FoundCoords,IntCoord_t::TORSION,{AtomI,AtomJ,AtomK,AtomL});
                 }//Close AtomL
                 if(AtomK<AtomI)continue;//Avoid 2x counting angle
-                if(!Conns[AtomI].count(AtomK))//Ensure it's not a three-membered ring
+                if(!Conns.bonded(AtomI,AtomK))//Ensure it's not a three-membered ring
                 {
-                    pair13.insert(std::make_pair(AtomI,AtomK));
-                    add_coord(FoundCoords,IntCoord_t::PAIR13,{AtomI,AtomJ,AtomK});
+                    excluded.push_back({Index_t(AtomI),Index_t(AtomK),
+                                        ExcludedPair::PAIR13});
+                    if(want_pair13)
+                        add_coord(FoundCoords,IntCoord_t::PAIR13,{AtomI,AtomJ,AtomK});
                 }
-                add_coord(FoundCoords,IntCoord_t::ANGLE,{AtomI,AtomJ,AtomK});
-                if(Conns[AtomJ].size()==3){
-                    for(size_t AtomL: Conns[AtomJ]){
+                if(want_angle)
+                    add_coord(FoundCoords,IntCoord_t::ANGLE,{AtomI,AtomJ,AtomK});
+                if(want_imp && Conns.neighbors(AtomJ).size()==3){
+                    for(size_t AtomL: Conns.neighbors(AtomJ)){
                         if(AtomL==AtomK||AtomL==AtomI||AtomL<AtomK)continue;
                         add_coord(FoundCoords,IntCoord_t::IMPTORSION,{AtomI,AtomJ,AtomK,AtomL});
                     }//Close AtomL imptorsion
                 }//Close if imptorsion
             }//Close Atom K
             if(AtomJ<AtomI)continue; //Avoid 2x counting bond
-            pair12.insert(std::make_pair(AtomI,AtomJ));
-            add_coord(FoundCoords,IntCoord_t::BOND,{AtomI,AtomJ});
+            excluded.push_back({Index_t(AtomI),Index_t(AtomJ),
+                                ExcludedPair::PAIR12});
+            if(want_bond)add_coord(FoundCoords,IntCoord_t::BOND,{AtomI,AtomJ});
         }//Close Atom J     
     }//Close AtomI
-    for(size_t AtomI=0;AtomI<NAtoms;++AtomI){
+
+    //With the excluded pairs sorted the remaining pairs can be found in one
+    //pass, and there are few enough 1,4 pairs to size the lists up front
+    std::sort(excluded.begin(),excluded.end());
+    size_t n14=0,nexcluded=0;
+    for(size_t k=0;k<excluded.size();++k){
+        if(k && excluded[k].i==excluded[k-1].i && excluded[k].j==excluded[k-1].j)
+            continue;
+        ++nexcluded;
+        if(excluded[k].kind==ExcludedPair::PAIR14)++n14;
+    }
+    const size_t npairs=want_pair?NAtoms*(NAtoms-1)/2-nexcluded:0;
+    for(const auto& pi:{make_pair(IntCoord_t::PAIR,npairs),
+                        make_pair(IntCoord_t::PAIR14,want_pair14?n14:0)}){
+        if(!pi.second)continue;
+        AtomTuples& atoms=FoundCoords.atom_numbers[pi.first]=AtomTuples(2);
+        atoms.reserve(pi.second);
+        FoundCoords.coords[pi.first].reserve(pi.second);
+    }
+    //Without the other pairs the 1,4 pairs are the excluded ones whose closest
+    //relationship is 1,4
+    if(want_pair14 && !want_pair)
+        for(size_t k=0;k<excluded.size();++k){
+            const ExcludedPair& ek=excluded[k];
+            if(ek.kind!=ExcludedPair::PAIR14)continue;
+            if(k && excluded[k-1].i==ek.i && excluded[k-1].j==ek.j)continue;
+            add_coord(FoundCoords,IntCoord_t::PAIR14,{ek.i,ek.j});
+        }
+    auto ex=excluded.begin();
+    for(size_t AtomI=0;AtomI<NAtoms && want_pair;++AtomI){
         for(size_t AtomJ=AtomI+1;AtomJ<NAtoms;++AtomJ){
-            auto pair=std::make_pair(AtomI,AtomJ);
-            if(pair12.count(pair)||pair13.count(pair))continue;
-            const bool is14=pair14.count(pair);
+            while(ex!=excluded.end() &&
+                  (ex->i<AtomI || (ex->i==AtomI && ex->j<AtomJ)))++ex;
+            const bool is_excluded=ex!=excluded.end() && ex->i==AtomI &&
+                                   ex->j==AtomJ;
+            if(is_excluded &&
+               (ex->kind!=ExcludedPair::PAIR14 || !want_pair14))continue;
             std::string ctype=IntCoord_t::PAIR;
-            if(is14)ctype=IntCoord_t::PAIR14;
+            if(is_excluded)ctype=IntCoord_t::PAIR14;
             add_coord(FoundCoords,ctype,{AtomI,AtomJ});
         }
     }
+    color_coords(FoundCoords);
+    index_bonds(FoundCoords);
+    FMANII_RECORD_PHASE("get_coords",timer.seconds(),ncoords(FoundCoords),
+                        nbytes(FoundCoords));
+    FMANII_TRACE(timer,"get_coords","phase",ncoords(FoundCoords));
     return FoundCoords;
 }
 
+void color_coords(Molecule& mol){
+    const size_t natoms=mol.carts->size()/3;
+    mol.colors.clear();
+    for(const auto& type:{IntCoord_t::BOND,IntCoord_t::ANGLE,
+                          IntCoord_t::TORSION,IntCoord_t::IMPTORSION})
+        if(mol.atom_numbers.count(type))
+            mol.colors[type]=Coloring(mol.atom_numbers.at(type),natoms);
+}
+
+void index_bonds(Molecule& mol){
+    mol.bond_refs.clear();
+    mol.bond_vectors=BondVectors();
+    if(!mol.atom_numbers.count(IntCoord_t::BOND))return;
+    const AtomTuples& bonds=mol.atom_numbers.at(IntCoord_t::BOND);
+    const size_t natoms=mol.carts->size()/3;
+    for(const auto& type:{IntCoord_t::ANGLE,IntCoord_t::TORSION,
+                          IntCoord_t::IMPTORSION}){
+        BondRefs refs;
+        if(mol.atom_numbers.count(type) &&
+           BondRefs::find(type,mol.atom_numbers.at(type),bonds,natoms,refs))
+            mol.bond_refs[type]=std::move(refs);
+    }
+    mol.bond_vectors=BondVectors(*mol.carts,bonds,mol.cell.get());
+}
+
+void update_coords(Molecule& mol,const Vector& Carts){
+    CHECK(Carts.size()==mol.carts->size(),"Number of atoms has changed");
+    mol.carts=std::make_shared<Vector>(Carts);
+    const Cell* cell=mol.cell.get();
+    const bool has_bonds=mol.atom_numbers.count(IntCoord_t::BOND) &&
+                         mol.bond_vectors.size();
+    if(has_bonds)
+        mol.bond_vectors=BondVectors(Carts,mol.atom_numbers.at(IntCoord_t::BOND),
+                                     cell);
+    for(auto& ci:mol.coords){
+        const auto coord=get_intcoord(ci.first);
+        const AtomTuples& atoms=mol.atom_numbers.at(ci.first);
+        Vector& values=ci.second;
+        if(has_bonds && ci.first==IntCoord_t::BOND){
+            values=mol.bond_vectors.lengths();
+            continue;
+        }
+        if(mol.bond_refs.count(ci.first)){
+            const BondRefs& refs=mol.bond_refs.at(ci.first);
+            parallel_for(atoms.size(),[&](size_t,size_t begin,size_t end){
+                for(size_t i=begin;i<end;++i)
+                    refs.deriv(0,mol.bond_vectors,i,&values[i]);
+            });
+            continue;
+        }
+        //Distances are most of the coordinates, so skip the generic interface
+        const bool is_dist=ci.first==IntCoord_t::BOND||
+                           ci.first==IntCoord_t::PAIR||
+                           ci.first==IntCoord_t::PAIR14;
+        const Index_t* pairs=atoms.data().data();
+        parallel_for(atoms.size(),[&](size_t,size_t begin,size_t end){
+            for(size_t i=begin;i<end;++i){
+                if(!is_dist){
+                    values[i]=coord->deriv(0,Carts,atoms[i],cell)[0];
+                    continue;
+                }
+                array<double,3> dr=diff(&Carts[3*pairs[2*i]],
+                                        &Carts[3*pairs[2*i+1]]);
+                if(cell)dr=cell->minimum_image(dr);
+                values[i]=mag(dr);
+            }
+        });
+    }
+}
+
+//Assigns the A and B coefficients of a 6-12 term from the force field's table
+//of class pairs, returns false if the table can not be used for this system
+inline bool assign_lj(ParamSet& ps,
+                      const FFTerm_t& term_type,
+                      const Molecule& sys,
+                      const ForceField& ff,
+                      const IVector& Types,
+                      bool skip_missing)
+{
+    if(term_type.first!=Model_t::LENNARD_JONES)return false;
+    if(!ff.combrules.count({Model_t::LENNARD_JONES,Param_t::sigma}) ||
+       !ff.combrules.count({Model_t::LENNARD_JONES,Param_t::epsilon}))
+        return false;
+    const bool use_class=ff.paramtypes.at(term_type)==TypeTypes_t::CLASS;
+    const LJTable table=ff.lj_table(term_type);
+    vector<Index_t> rows(Types.size());
+    for(size_t i=0;i<Types.size();++i){
+        size_t id=Types[i];
+        if(use_class && !ff.type2class.count(id))return false;
+        if(use_class)id=ff.type2class.at(id);
+        if(!table.index.count(id))return false;
+        rows[i]=table.index.at(id);
+        CHECK(skip_missing||table.found[rows[i]],
+              "No 6-12 parameters for "+string(use_class?"class ":"type ")+
+              to_string(id));
+    }
+    const AtomTuples& pairs=sys.atom_numbers.at(term_type.second);
+    Vector &As=ps[term_type][Param_t::A],&Bs=ps[term_type][Param_t::B];
+    As.reserve(pairs.size());
+    Bs.reserve(pairs.size());
+    for(const AtomTuple pair:pairs){
+        const size_t idx=rows[pair[0]]*table.n+rows[pair[1]];
+        As.push_back(table.A[idx]);
+        Bs.push_back(table.B[idx]);
+    }
+    return true;
+}
+
 ParamSet assign_params(const Molecule& sys,
                        const ForceField& ff,
                        const IVector& Types,
-                       bool skip_missing)
+                       bool skip_missing,
+                       const TermFilter& filter)
  {
+    FMANII_TIMER(timer);
     ParamSet ps;
     for(const auto& termi:ff.terms){
         const FFTerm_t term_type=termi.first;
-        //for(const auto& coordi:termi.second.coords){
-            for(auto parami:termi.second.model().params){
-                const auto& intcoord_name=term_type.second;
-                if(!sys.atom_numbers.count(intcoord_name))
-                    continue;//Not all systems contain all intcoords a ff knows
+        const auto& intcoord_name=term_type.second;
+        if(!sys.atom_numbers.count(intcoord_name))
+            continue;//Not all systems contain all intcoords a ff knows
+        if(filter && !filter(term_type))continue;
+        FMANII_TIMER(term_timer);
+        if(!assign_lj(ps,term_type,sys,ff,Types,skip_missing))
+            for(auto parami:termi.second.model().params)
                 ps[term_type][parami]=
                     ff.assign_param(term_type,parami,
                          sys.atom_numbers.at(intcoord_name),Types,skip_missing);
-            }
-        //}
+        FMANII_RECORD_TERM("assign_params",term_type,term_timer.seconds(),
+                           sys.atom_numbers.at(intcoord_name).size(),
+                           nbytes(ps[term_type]));
+        FMANII_TRACE(term_timer,term_type.first+" "+intcoord_name,
+                     "assign_params",sys.atom_numbers.at(intcoord_name).size());
     }
+    FMANII_RECORD_PHASE("assign_params",timer.seconds(),ncoords(sys),
+                        nbytes(ps));
+    FMANII_TRACE(timer,"assign_params","phase",ncoords(sys));
     return ps;
 }
 
 DerivType deriv(size_t order,
                 const ForceField& ff,
                 const ParamSet& ps,
-                const Molecule& coords)
+                const Molecule& coords,
+                const TermFilter& filter)
 {
+   FMANII_TIMER(timer);
    DerivType rv;
-   for(const auto& i:ps){
-        const auto& term_type=i.first;
-        Vector d=ff.terms.at(term_type).deriv(order,i.second,coords);
-        if(ff.scale_factors.count(term_type))
-            for(double& di:d)di*=ff.scale_factors.at(term_type);
-        rv.emplace(term_type,std::move(d));
-    }
+   auto keep=[&](const FFTerm_t& term){return !filter || filter(term);};
+   //LJ and electrostatics share their pairs, so do them together when we can
+   if(order<2)
+       for(const auto& pair_type:{IntCoord_t::PAIR,IntCoord_t::PAIR14})
+           if(keep({Model_t::LENNARD_JONES,pair_type}) &&
+              keep({Model_t::ELECTROSTATICS,pair_type}) &&
+              can_fuse(ff,ps,pair_type)){
+               FMANII_TIMER(term_timer);
+               nonbonded_deriv(order,ff,ps,coords,pair_type,rv);
+               for(const auto& model:{Model_t::LENNARD_JONES,
+                                      Model_t::ELECTROSTATICS}){
+                   const FFTerm_t term_type(model,pair_type);
+                   FMANII_RECORD_TERM("deriv",term_type,term_timer.seconds()/2,
+                                coords.atom_numbers.at(pair_type).size(),
+                                detail::bytes_of(rv.at(term_type)));
+               }
+               FMANII_TRACE(term_timer,string("Fused nonbonded ")+pair_type,"deriv",
+                            coords.atom_numbers.at(pair_type).size());
+           }
+   //Gradients of colored coordinates are spread over all of the threads by
+   //FFTerm::deriv, so those terms are done one at a time.  Everything else is
+   //independent, so each chunk of the remaining terms gets a thread.
+   vector<ParamSet::const_iterator> todo,colored;
+   for(auto i=ps.begin();i!=ps.end();++i){
+       if(rv.count(i->first) || !keep(i->first))continue;//Fused or rejected
+       if(order==1 && coords.colors.count(i->first.second))colored.push_back(i);
+       else todo.push_back(i);
+   }
+   auto run_term=[&](ParamSet::const_iterator term,Vector& d){
+       FMANII_TIMER(term_timer);
+       const FFTerm_t& term_type=term->first;
+       d=ff.terms.at(term_type).deriv(order,term->second,coords);
+       if(ff.scale_factors.count(term_type))
+           for(double& di:d)di*=ff.scale_factors.at(term_type);
+       FMANII_RECORD_TERM("deriv",term_type,term_timer.seconds(),
+                          coords.atom_numbers.at(term_type.second).size(),
+                          detail::bytes_of(d));
+       FMANII_TRACE(term_timer,term_type.first+" "+term_type.second,"deriv",
+                    coords.atom_numbers.at(term_type.second).size());
+   };
+   for(auto term:colored)run_term(term,rv[term->first]);
+   vector<Vector> ds(todo.size());
+   parallel_for(todo.size(),[&](size_t,size_t begin,size_t end){
+       for(size_t t=begin;t<end;++t)run_term(todo[t],ds[t]);
+   });
+   for(size_t t=0;t<todo.size();++t)
+       rv.emplace(todo[t]->first,std::move(ds[t]));
+   FMANII_RECORD_PHASE("deriv",timer.seconds(),ncoords(coords,ps),nbytes(rv));
+   FMANII_TRACE(timer,"deriv"+to_string(order),"phase",ncoords(coords,ps));
+   return rv;
+}
+
+void add_gradient(const ForceField& ff,
+                  const ParamSet& ps,
+                  const Molecule& coords,
+                  Vector& grad,
+                  EnergyType* energies,
+                  const TermFilter& filter)
+{
+   FMANII_TIMER(timer);
+   CHECK(grad.size()==coords.carts->size(),
+         "Gradient needs 3 elements per atom");
+   if(energies)energies->clear();
+   auto keep=[&](const FFTerm_t& term){return !filter || filter(term);};
+   set<FFTerm_t> fused;
+   for(const auto& pair_type:{IntCoord_t::PAIR,IntCoord_t::PAIR14}){
+       const FFTerm_t lj_term(Model_t::LENNARD_JONES,pair_type),
+                      cl_term(Model_t::ELECTROSTATICS,pair_type);
+       if(!keep(lj_term) || !keep(cl_term) || !can_fuse(ff,ps,pair_type))
+           continue;
+       FMANII_TIMER(term_timer);
+       double elj=0.0,ecl=0.0;
+       nonbonded_add(ff,ps,coords,pair_type,grad.data(),grad.data(),
+                     energies?&elj:nullptr,energies?&ecl:nullptr);
+       if(energies){
+           (*energies)[lj_term]=elj;
+           (*energies)[cl_term]=ecl;
+       }
+       fused.insert({lj_term,cl_term});
+       FMANII_TRACE(term_timer,string("Fused nonbonded ")+pair_type,
+                    "gradient",coords.atom_numbers.at(pair_type).size());
+   }
+   //Every term adds to the same buffer so they go one at a time, the
+   //colored ones still spread their scatter over the threads
+   for(const auto& pi:ps){
+       const FFTerm_t& term_type=pi.first;
+       if(fused.count(term_type) || !keep(term_type))continue;
+       FMANII_TIMER(term_timer);
+       double egy=0.0;
+       const double scale=ff.scale_factors.count(term_type)?
+                          ff.scale_factors.at(term_type):1.0;
+       ff.terms.at(term_type).add_gradient(pi.second,coords,scale,grad.data(),
+                                           energies?&egy:nullptr);
+       if(energies)(*energies)[term_type]=egy;
+       FMANII_RECORD_TERM("gradient",term_type,term_timer.seconds(),
+                          coords.atom_numbers.at(term_type.second).size(),0);
+       FMANII_TRACE(term_timer,term_type.first+" "+term_type.second,
+                    "gradient",coords.atom_numbers.at(term_type.second).size());
+   }
+   FMANII_RECORD_PHASE("gradient",timer.seconds(),ncoords(coords,ps),0);
+   FMANII_TRACE(timer,"gradient","phase",ncoords(coords,ps));
+}
+
+//Coordinates handed to a model at once when only energies are needed
+constexpr size_t energy_block=512;
+
+//The energy of one term, computed block by block from the geometry
+inline double term_energy(const FFTerm& term,
+                          const map<string,Vector>& ps,
+                          const AtomTuples& atoms,
+                          const Vector& carts,
+                          const Cell* cell)
+{
+    const size_t n=atoms.size(),nblocks=(n+energy_block-1)/energy_block,
+                 nthreads=std::max<size_t>(get_num_threads(),1);
+    const InternalCoordinates& coord=term.coords();
+    const ModelPotential& model=term.model();
+    Vector sums(nthreads,0.0);
+    const size_t nchunks=parallel_for(nblocks,nthreads,[&](size_t chunk,
+                                                        size_t begin,
+                                                        size_t end){
+        vector<Vector> qs(1);
+        map<string,Vector> block_ps;
+        for(size_t b=begin;b<end;++b){
+            const size_t first=b*energy_block,
+                         last=std::min(n,first+energy_block);
+            qs[0].resize(last-first);
+            for(size_t i=first;i<last;++i)
+                qs[0][i-first]=coord.value(carts,atoms[i],cell);
+            for(const auto& pi:ps){
+                const size_t stride=pi.second.size()/n;
+                block_ps[pi.first].assign(pi.second.begin()+stride*first,
+                                          pi.second.begin()+stride*last);
+            }
+            sums[chunk]+=model.deriv(0,block_ps,qs)[0];
+        }
+    });
+    double rv=0.0;
+    for(size_t chunk=0;chunk<nchunks;++chunk)rv+=sums[chunk];
     return rv;
 }
 
+EnergyType energy(const ForceField& ff,
+                  const ParamSet& ps,
+                  const Molecule& coords,
+                  const TermFilter& filter,
+                  const Vector* geom)
+{
+   FMANII_TIMER(timer);
+   const Vector& carts=geom?*geom:*coords.carts;
+   CHECK(carts.size()==coords.carts->size(),"Number of atoms has changed");
+   auto keep=[&](const FFTerm_t& term){return !filter || filter(term);};
+   EnergyType rv;
+   for(const auto& pair_type:{IntCoord_t::PAIR,IntCoord_t::PAIR14}){
+       const FFTerm_t lj_term(Model_t::LENNARD_JONES,pair_type),
+                      cl_term(Model_t::ELECTROSTATICS,pair_type);
+       if(!keep(lj_term) || !keep(cl_term) || !can_fuse(ff,ps,pair_type))
+           continue;
+       FMANII_TIMER(term_timer);
+       nonbonded_add(ff,ps,coords,pair_type,nullptr,nullptr,&rv[lj_term],
+                     &rv[cl_term],&carts);
+       FMANII_TRACE(term_timer,string("Fused nonbonded ")+pair_type,
+                    "energy",coords.atom_numbers.at(pair_type).size());
+   }
+   for(const auto& pi:ps){
+       const FFTerm_t& term_type=pi.first;
+       if(rv.count(term_type) || !keep(term_type))continue;
+       FMANII_TIMER(term_timer);
+       const double scale=ff.scale_factors.count(term_type)?
+                          ff.scale_factors.at(term_type):1.0;
+       const AtomTuples& atoms=coords.atom_numbers.at(term_type.second);
+       rv[term_type]=scale*term_energy(ff.terms.at(term_type),pi.second,atoms,
+                                       carts,coords.cell.get());
+       FMANII_RECORD_TERM("energy",term_type,term_timer.seconds(),
+                          atoms.size(),0);
+       FMANII_TRACE(term_timer,term_type.first+" "+term_type.second,
+                    "energy",atoms.size());
+   }
+   FMANII_RECORD_PHASE("energy",timer.seconds(),ncoords(coords,ps),0);
+   FMANII_TRACE(timer,"energy","phase",ncoords(coords,ps));
+   return rv;
+}
+
 shared_ptr<ModelPotential> get_potential(const string& name)
 {
     if(name==Model_t::HARMONICOSCILLATOR)
@@ -21,14 +21,27 @@
 
 #
 #include "ForceManII/FManIIDefs.hpp"
+#include "ForceManII/Cell.hpp"
+#include "ForceManII/Connectivity.hpp"
 #include "ForceManII/ForceField.hpp"
 #include "ForceManII/InternalCoordinates.hpp"
 #include "ForceManII/ModelPotential.hpp"
 #include "ForceManII/FFTerm.hpp"
+#include "ForceManII/EvaluationPlan.hpp"
+#include "ForceManII/IncrementalEnergy.hpp"
+#include "ForceManII/Minimize.hpp"
+#include "ForceManII/Constraints.hpp"
+#include "ForceManII/MolecularDynamics.hpp"
+#include "ForceManII/Elements.hpp"
+#include "ForceManII/Nonbonded.hpp"
+#include "ForceManII/Parallel.hpp"
+#include "ForceManII/Trajectory.hpp"
+#include "ForceManII/Profile.hpp"
 #include "ForceManII/ModelPotentials/HarmonicOscillator.hpp"
 #include "ForceManII/ModelPotentials/LennardJones.hpp"
 #include "ForceManII/ModelPotentials/FourierSeries.hpp"
 #include "ForceManII/ModelPotentials/Electrostatics.hpp"
+#include "ForceManII/ModelPotentials/Tabulated.hpp"
 
 #include <istream>
 #include <cmath>
@@ -78,6 +91,23 @@ ForceField parse_file(std::istream&& file,
                       double deg2rad=M_PI/180.0);
 
 
+///Term filters (see TermFilter)
+///@{
+
+///Keeps the terms whose model is not in \p models and whose internal
+///coordinate is not in \p coords
+TermFilter skip_terms(const std::vector<std::string>& models,
+                      const std::vector<std::string>& coords);
+
+///Keeps only \p term
+TermFilter only_term(const FFTerm_t& term);
+
+///The types of internal coordinates used by the terms of \p ff that
+///\p filter keeps
+std::set<std::string> coords_needed(const ForceField& ff,
+                                    const TermFilter& filter);
+///@}
+
 /**\brief A function that processes the input and returns a set of internal
  *        coordinates
  *
@@ -96,41 +126,127 @@ ForceField parse_file(std::istream&& file,
  *                  element i is a vector of atoms bonded to atom i (all atoms
  *                  must have a vector associated with them, even if it is
  *                  empty
- * \param[in] ff A ForceField instance with the details of your forcefield
+ * \param[in] cell The unit cell if the system is periodic.  Coordinates are
+ *                 then computed with the minimum image convention.
+ * \param[in] coord_types If not null, only these types of internal
+ *                 coordinates are found (see coords_needed())
  * \return Your system's internal coordinates, in a.u.
  * 
  */
 Molecule get_coords(const Vector& Carts,
-                      const ConnData& Conns);
+                      const ConnData& Conns,
+                      const Cell* cell=nullptr,
+                      const std::set<std::string>* coord_types=nullptr);
+
+///Same as above, but with the bonds in compressed form
+Molecule get_coords(const Vector& Carts,
+                      const Connectivity& Conns,
+                      const Cell* cell=nullptr,
+                      const std::set<std::string>* coord_types=nullptr);
+
+/** \brief Colors the bonds, angles, torsions, and impropers of a system
+ *
+ *  get_coords() calls this, call it again after changing the atoms of any of
+ *  those coordinates.  See Molecule::colors.
+ */
+void color_coords(Molecule& mol);
+
+/** \brief Finds the bonds of each angle, torsion, and improper of a system
+ *         and computes the vectors along the bonds
+ *
+ *  get_coords() calls this, call it again after changing the atoms of any
+ *  coordinate.  Types with a coordinate that isn't made of bonds are skipped
+ *  and computed from the Cartesian coordinates.  See Molecule::bond_refs.
+ */
+void index_bonds(Molecule& mol);
+
+/** \brief Moves the atoms of a system found by get_coords()
+ *
+ *  The internal coordinates keep their atoms, only their values are
+ *  recomputed, which is much cheaper than finding them again.
+ *
+ *  \param[in,out] mol The system to update
+ *  \param[in] Carts The new Cartesian coordinates, in a.u., of the same atoms
+ */
+void update_coords(Molecule& mol,const Vector& Carts);
 
 
 /**\brief A function that assigns the final parameters to a system
  *
+ *  Lennard-Jones terms whose force field has combining rules for sigma and
+ *  epsilon are given the combined coefficients Param_t::A and Param_t::B
+ *  instead (see ForceField::lj_table()).
  *
  *  \param[in] coords The internal coordinates of the system
  *  \param[in] ff The force field to use for assigning parameters
  *  \param[in] types A map from atom number to atom type
  *  \param[in] skip_missing If true missing parameters will be counted as zero
+ *  \param[in] filter Terms it rejects are not assigned parameters
  *  \return The parameters of your system
  *
  */
 ParamSet assign_params(const Molecule& coords,
                        const ForceField& ff,
                        const IVector& types,
-                       bool skip_missing=true);
+                       bool skip_missing=true,
+                       const TermFilter& filter=nullptr);
 
+///Computes the derivative of each term in \p ps that \p filter keeps
 DerivType deriv(size_t order,
                 const ForceField& ff,
                 const ParamSet& ps,
-                const Molecule& coords);
+                const Molecule& coords,
+                const TermFilter& filter=nullptr);
 
+/** \brief Adds the gradient of all terms in \p ps that \p filter keeps to
+ *         \p grad
+ *
+ *  Unlike deriv(1,...) the terms are summed as they are computed, so no
+ *  gradient per term is ever allocated.  Scale factors are applied.
+ *
+ *  \param[in,out] grad 3 elements per atom, the gradient is added to it
+ *  \param[out] energies If not null, set to the energy of each term
+ */
+void add_gradient(const ForceField& ff,
+                  const ParamSet& ps,
+                  const Molecule& coords,
+                  Vector& grad,
+                  EnergyType* energies=nullptr,
+                  const TermFilter& filter=nullptr);
+
+/** \brief The energy of each term in \p ps that \p filter keeps, computed
+ *         straight from the Cartesian coordinates
+ *
+ *  Each coordinate's value is computed and handed to its model in small
+ *  blocks, so no derivatives, values of the coordinates (\p coords.coords),
+ *  or bond vectors are used or stored.  For screening many geometries of one
+ *  system.  Scale factors are applied.
+ *
+ *  \param[in] coords Only the atoms of each coordinate and the cell are used
+ *  \param[in] carts If not null, the geometry to use instead of
+ *                   \p coords.carts, with the same atoms
+ */
+EnergyType energy(const ForceField& ff,
+                  const ParamSet& ps,
+                  const Molecule& coords,
+                  const TermFilter& filter=nullptr,
+                  const Vector* carts=nullptr);
+
+///Finds the internal coordinates and parameters of a system and computes the
+///derivatives of the terms \p filter keeps.  Coordinates only used by
+///rejected terms are never found.
 inline DerivType run_forcemanii(size_t order,
                                 const Vector& Carts,
                                 const ConnData& conns,
                                 const ForceField& ff,
-                                const IVector& types){
-    const Molecule coords=get_coords(Carts,conns);
-    return deriv(order,ff,assign_params(coords,ff,types),coords);
+                                const IVector& types,
+                                const Cell* cell=nullptr,
+                                const TermFilter& filter=nullptr){
+    const std::set<std::string> needed=coords_needed(ff,filter);
+    const Molecule coords=get_coords(Carts,conns,cell,
+                                     filter?&needed:nullptr);
+    return deriv(order,ff,assign_params(coords,ff,types,true,filter),coords,
+                 filter);
 
 }
 
@@ -18,6 +18,10 @@
  */
 #pragma once
 
+#include "ForceManII/AtomTuples.hpp"
+#include "ForceManII/BondVectors.hpp"
+#include "ForceManII/Coloring.hpp"
+#include <functional>
 #include <map>
 #include <vector>
 #include <set>
@@ -35,6 +39,8 @@ namespace Param_t {
     constexpr auto q="q";///<The charge, in a.u., for point-charge, point-charge
     constexpr auto sigma="sigma";///<The minimum diameter of a 6-12 potential
     constexpr auto epsilon="epsilon";///<The well depth of a 6-12 potential
+    constexpr auto A="A";///<The coefficient of r^-12 in a 6-12 potential
+    constexpr auto B="B";///<The coefficient of -r^-6 in a 6-12 potential
 }
 
 ///These are the recognized types of IntCoords
@@ -89,6 +95,10 @@ namespace Terms_t{
 ///Type of a FFTerm
 using FFTerm_t=std::pair<std::string,std::string>;
 
+///Decides which terms of a force field are computed, an empty filter keeps
+///all of them
+using TermFilter=std::function<bool(const FFTerm_t&)>;
+
 
 ///Type of a quantity we are treating as a mathematical vector
 using Vector=std::vector<double>;
@@ -102,6 +112,8 @@ using cSharedVector=std::shared_ptr<const Vector>;
 ///Array of unsigned long integers
 using IVector=std::vector<size_t>;
 
+class Cell;
+
 ///Structure to hold the details of the molecular system
 struct Molecule{
     ///The internal coordinates arranged by type
@@ -110,8 +122,24 @@ struct Molecule{
     ///The Cartesian coordinates of the system
     cSharedVector carts;
 
-    ///A list such that element i is the NAtoms associated with the i-th coord
-    std::map<std::string,std::vector<IVector>> atom_numbers;
+    ///The atoms of each internal coordinate arranged by type, element i of a
+    ///type is the atoms of the i-th coordinate of that type
+    std::map<std::string,AtomTuples> atom_numbers;
+
+    ///For the bonded types of coordinates, groups of coordinates that share no
+    ///atoms (see color_coords()), the gradient is added up in parallel over
+    ///each group.  Types without a coloring are added up serially.
+    std::map<std::string,Coloring> colors;
+
+    ///The angles, torsions, and impropers whose bonds were found (see
+    ///index_bonds()) are computed from bond_vectors instead of carts
+    std::map<std::string,BondRefs> bond_refs;
+
+    ///The vectors along the bonds at carts, empty if index_bonds() wasn't run
+    BondVectors bond_vectors;
+
+    ///The periodic cell of the system, null if the system is not periodic
+    std::shared_ptr<const Cell> cell;
 };
 
 ///Array such that element i is a vector of the atoms bonded to atom i
@@ -123,5 +151,8 @@ using ParamSet=std::map<FFTerm_t,std::map<std::string,Vector>>;
 ///An array of the requested derivatives sorted by force field term type
 using DerivType=std::map<FFTerm_t,Vector>;
 
+///The energy of each force field term
+using EnergyType=std::map<FFTerm_t,double>;
+
 
 }//end namespace
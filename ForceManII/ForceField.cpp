@@ -22,6 +22,7 @@
 #include<algorithm>
 #include<sstream>
 #include<iterator>
+#include<set>
 
 using namespace std;
 
@@ -142,17 +143,51 @@ inline Vector handle_other(const FFTerm_t& term_type,
             }while(prev_permutation(is_zero.begin(),is_zero.end()));
         }
     }
+    return Vector();
 }
 
 
+LJTable ForceField::lj_table(const FFTerm_t& term_type)const{
+    const bool use_class=paramtypes.at(term_type)==TypeTypes_t::CLASS;
+    const auto srule=make_pair(term_type.first,string(Param_t::sigma)),
+               erule=make_pair(term_type.first,string(Param_t::epsilon));
+    set<size_t> ids;
+    for(const auto& tc:type2class)ids.insert(use_class?tc.second:tc.first);
+    LJTable table;
+    table.n=ids.size();
+    vector<Vector> ss,es;
+    for(size_t id:ids){
+        table.index[id]=ss.size();
+        ss.push_back(handle_combrule(term_type,Param_t::sigma,{id},params,
+                                     pimpl_->links,true,use_class));
+        es.push_back(handle_combrule(term_type,Param_t::epsilon,{id},params,
+                                     pimpl_->links,true,use_class));
+        table.found.push_back(ss.back().size() && es.back().size());
+    }
+    table.A.resize(table.n*table.n);
+    table.B.resize(table.n*table.n);
+    for(size_t i=0;i<table.n;++i)
+        for(size_t j=0;j<table.n;++j){
+            Vector sij(ss[i]),eij(es[i]);
+            sij.insert(sij.end(),ss[j].begin(),ss[j].end());
+            eij.insert(eij.end(),es[j].begin(),es[j].end());
+            if(!sij.size() || !eij.size())continue;//Neither has parameters
+            const double s=combrules.at(srule)(sij),e=combrules.at(erule)(eij);
+            const double s6=s*s*s*s*s*s;
+            table.A[i*table.n+j]=e*s6*s6;
+            table.B[i*table.n+j]=2.0*e*s6;
+        }
+    return table;
+}
+
 Vector ForceField::assign_param(const FFTerm_t& term_type,
                                 const string& parami,
-                                const vector<IVector>& atom_numbers,
+                                const AtomTuples& atom_numbers,
                                 const IVector& atom2type,
                                 bool skip_missing)const{
     const bool use_class=paramtypes.at(term_type)==TypeTypes_t::CLASS;
     Vector rv;
-    for(auto typei:atom_numbers){
+    for(const AtomTuple typei:atom_numbers){
         IVector types;
         transform(typei.begin(),typei.end(),back_inserter(types),
             [&](size_t t){t=atom2type[t];return use_class?type2class.at(t):t;}
@@ -29,6 +29,19 @@
 namespace FManII {
 namespace detail{class FFImpl;}
 
+/** \brief The combined 6-12 coefficients of every pair of atom classes
+ *
+ *  For classes with rows i and j, the energy of a pair at distance r is
+ *  A[i*n+j]/r^12-B[i*n+j]/r^6.
+ */
+struct LJTable{
+    std::unordered_map<size_t,size_t> index;///<Atom class (or type) to row
+    size_t n=0;///<The number of rows (and columns)
+    Vector A;///<The n by n r^-12 coefficients
+    Vector B;///<The n by n r^-6 coefficients
+    std::vector<bool> found;///<Does the class in row i have parameters?
+};
+
 /** \brief  A struct to hold the details about a force field
  *
  * This class holds the definitions of a force field not a
@@ -84,11 +97,27 @@ public:
     std::map<PTerm_t,combiner> combrules;///< How to combine parameters
     std::map<FFTerm_t,double> scale_factors;///<Scale terms by how much?
 
+    /** \brief Combines the 6-12 parameters of every pair of atom classes
+     *
+     *  The combination rules for \p term_type's sigma and epsilon are applied
+     *  once per pair of classes (or types, depending on the term), rather than
+     *  once per pair of atoms.  Classes missing one of the parameters are
+     *  combined the same way assign_param would and are flagged in
+     *  LJTable::found.
+     *
+     *  The table is made from the force field's current members on every
+     *  call; assign_params makes it once per call for each 6-12 term.
+     *
+     *  \param[in] term_type A Lennard-Jones term with combination rules
+     *  \return The table for all classes known to this force field
+     */
+    LJTable lj_table(const FFTerm_t& term_type)const;
+
     /** \brief Given a set of internal coordinates assigns parameters
      *
      *  \param[in] term_type The model and intcoordinate of the term
      *  \param[in] parmi The type of parameter
-     *  \param[in] atom_numbers A vector of the ordered sets of atom numbers in each coordinate
+     *  \param[in] atom_numbers The ordered sets of atom numbers in each coordinate
      *  \param[in] atom2type A mapping from atom number to atom type
      *  \param[in] skip_missing If true missing parameters will be ignored
      *
@@ -96,7 +125,7 @@ public:
      */
     Vector assign_param(const FFTerm_t& term_type,
                         const std::string& parmi,
-                        const std::vector<IVector>& atom_numbers,
+                        const AtomTuples& atom_numbers,
                         const IVector& atom2type,
                         bool skip_missing)const;
 
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "ForceManII/IncrementalEnergy.hpp"
+#include "ForceManII/Common.hpp"
+#include "ForceManII/FManII.hpp"
+#include "ForceManII/Profile.hpp"
+#include <algorithm>
+
+using namespace std;
+namespace FManII {
+
+//The parameters of coordinates idx of a term with n coordinates
+inline map<string,Vector> select(const map<string,Vector>& ps,size_t n,
+                                 const IVector& idx){
+    map<string,Vector> rv;
+    for(const auto& pi:ps){
+        const size_t stride=pi.second.size()/n;
+        Vector& sub=rv[pi.first];
+        sub.reserve(stride*idx.size());
+        for(size_t i:idx)
+            sub.insert(sub.end(),pi.second.begin()+stride*i,
+                       pi.second.begin()+stride*(i+1));
+    }
+    return rv;
+}
+
+IncrementalEnergy::IncrementalEnergy(const EvaluationPlan& plan):
+    plan_(plan),
+    new_number_(plan.natoms()),
+    carts_(*plan.molecule().carts),
+    values_(plan.molecule().coords)
+{
+    const IVector& order=plan_.atom_order();
+    for(size_t i=0;i<new_number_.size();++i)
+        new_number_[order.empty()?i:order[i]]=i;
+    const Molecule& mol=plan_.molecule();
+    for(const auto& pi:plan_.params()){
+        const string& type=pi.first.second;
+        if(index_.count(type))continue;
+        const AtomTuples& atoms=mol.atom_numbers.at(type);
+        AtomIndex& idx=index_[type];
+        idx.offsets.assign(plan_.natoms()+1,0);
+        for(const Index_t ai:atoms.data())++idx.offsets[ai+1];
+        for(size_t i=0;i<plan_.natoms();++i)idx.offsets[i+1]+=idx.offsets[i];
+        idx.coords.resize(atoms.data().size());
+        IVector fill(idx.offsets.begin(),idx.offsets.end()-1);
+        for(size_t c=0;c<atoms.size();++c)
+            for(const Index_t ai:atoms[c])idx.coords[fill[ai]++]=c;
+    }
+    for(const auto& di:FManII::deriv(0,plan_.force_field(),plan_.params(),mol))
+        energies_[di.first]=di.second[0];
+}
+
+double IncrementalEnergy::energy()const{
+    double rv=0.0;
+    for(const auto& ei:energies_)rv+=ei.second;
+    return rv;
+}
+
+double IncrementalEnergy::propose(const IVector& atoms,const Vector& carts){
+    FMANII_TIMER(timer);
+    CHECK(!pending_,"Accept or reject the last move first");
+    CHECK(carts.size()==3*atoms.size(),"Need 3 coordinates per moved atom");
+    for(size_t ai:atoms)
+        CHECK(ai<new_number_.size(),"Atom "+to_string(ai)+
+              " is not in the system");
+    IVector sorted(atoms);
+    sort(sorted.begin(),sorted.end());
+    CHECK(adjacent_find(sorted.begin(),sorted.end())==sorted.end(),
+          "Each atom can only be moved once per move");
+    moved_.clear();
+    old_carts_.clear();
+    for(size_t i=0;i<atoms.size();++i){
+        const size_t ai=new_number_[atoms[i]];
+        moved_.push_back(ai);
+        old_carts_.insert(old_carts_.end(),&carts_[3*ai],&carts_[3*ai+3]);
+        copy(&carts[3*i],&carts[3*i+3],&carts_[3*ai]);
+    }
+    pending_=true;
+
+    const Molecule& mol=plan_.molecule();
+    changed_.clear();
+    new_values_.clear();
+    for(const auto& ii:index_){
+        const AtomIndex& idx=ii.second;
+        IVector& changed=changed_[ii.first];
+        for(size_t ai:moved_)
+            changed.insert(changed.end(),idx.coords.begin()+idx.offsets[ai],
+                           idx.coords.begin()+idx.offsets[ai+1]);
+        sort(changed.begin(),changed.end());
+        changed.erase(unique(changed.begin(),changed.end()),changed.end());
+        const auto coord=get_intcoord(ii.first);
+        const AtomTuples& tuples=mol.atom_numbers.at(ii.first);
+        Vector& values=new_values_[ii.first];
+        values.reserve(changed.size());
+        for(size_t c:changed)
+            values.push_back(coord->value(carts_,tuples[c],mol.cell.get()));
+    }
+
+    const ForceField& ff=plan_.force_field();
+    deltas_.clear();
+    double rv=0.0;
+    for(const auto& pi:plan_.params()){
+        const FFTerm_t& term=pi.first;
+        const IVector& changed=changed_.at(term.second);
+        if(changed.empty())continue;
+        const Vector& old_values=values_.at(term.second);
+        vector<Vector> qs(1);
+        qs[0].reserve(changed.size());
+        for(size_t c:changed)qs[0].push_back(old_values[c]);
+        const map<string,Vector> ps=select(pi.second,old_values.size(),
+                                           changed);
+        const ModelPotential& model=ff.terms.at(term).model();
+        const double old_egy=model.deriv(0,ps,qs)[0];
+        qs[0]=new_values_.at(term.second);
+        const double scale=ff.scale_factors.count(term)?
+                           ff.scale_factors.at(term):1.0;
+        const double delta=scale*(model.deriv(0,ps,qs)[0]-old_egy);
+        deltas_[term]=delta;
+        rv+=delta;
+    }
+    FMANII_TRACE(timer,"propose","phase",moved_.size());
+    return rv;
+}
+
+void IncrementalEnergy::accept(){
+    CHECK(pending_,"No move to accept");
+    for(const auto& ci:changed_){
+        Vector& values=values_.at(ci.first);
+        const Vector& new_values=new_values_.at(ci.first);
+        for(size_t i=0;i<ci.second.size();++i)
+            values[ci.second[i]]=new_values[i];
+    }
+    for(const auto& di:deltas_)energies_[di.first]+=di.second;
+    pending_=false;
+}
+
+void IncrementalEnergy::reject(){
+    CHECK(pending_,"No move to reject");
+    //Backwards, so the first saved position of an atom is the one that stays
+    for(size_t i=moved_.size();i-->0;)
+        copy(&old_carts_[3*i],&old_carts_[3*i+3],&carts_[3*moved_[i]]);
+    pending_=false;
+}
+
+} //End namespace FManII
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+#include "ForceManII/EvaluationPlan.hpp"
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+
+/** \brief The energy of a system in which a few atoms move at a time, e.g. in
+ *         Monte Carlo sampling
+ *
+ *  Each move is proposed with propose(), which returns the change in energy,
+ *  and then either kept with accept() or undone with reject().  Only the
+ *  internal coordinates (including pairs) containing a moved atom are
+ *  recomputed, found through an index from each atom to its coordinates.
+ *  Moving k atoms of an N atom system thus costs O(k*N) for the pairs and
+ *  O(k) for everything else, instead of O(N^2).
+ *
+ *  The value of every coordinate is cached, so the old energy of the
+ *  affected coordinates comes from the cache and only their new values are
+ *  computed.  Accepted changes are summed onto the energy, so after many
+ *  moves it may differ from a full evaluation by rounding.
+ */
+class IncrementalEnergy{
+public:
+    /** \brief Starts at the plan's current geometry
+     *
+     *  The plan must outlive this object and is never moved by it.
+     */
+    explicit IncrementalEnergy(const EvaluationPlan& plan);
+
+    ///The total energy at the current geometry
+    double energy()const;
+
+    ///The energy of each term at the current geometry
+    const EnergyType& energies()const{return energies_;}
+
+    ///The current geometry, caller's numbering
+    Vector carts()const{return plan_.from_internal(carts_);}
+
+    /** \brief The change in energy if \p atoms move to \p carts
+     *
+     *  Until accept() or reject() is called the move is pending and no other
+     *  move may be proposed.
+     *
+     *  \param[in] atoms The atoms that move (caller's numbering)
+     *  \param[in] carts The new positions of \p atoms, 3 per atom, in a.u.
+     */
+    double propose(const IVector& atoms,const Vector& carts);
+
+    ///Keeps the pending move
+    void accept();
+
+    ///Undoes the pending move
+    void reject();
+
+private:
+    ///For each atom the coordinates of one type that contain it
+    struct AtomIndex{
+        IVector offsets;///<Atom i's coordinates are [offsets[i],offsets[i+1])
+        IVector coords;///<The coordinate numbers
+    };
+
+    const EvaluationPlan& plan_;
+    IVector new_number_;///<Internal number of each of the caller's atoms
+    Vector carts_;///<Internal numbering
+    std::map<std::string,Vector> values_;///<Value of each coordinate
+    std::map<std::string,AtomIndex> index_;
+    EnergyType energies_;
+
+    //The pending move
+    bool pending_=false;
+    IVector moved_;///<Internal numbers of the moved atoms
+    Vector old_carts_;///<Where the moved atoms were
+    std::map<std::string,IVector> changed_;///<Coordinates with a moved atom
+    std::map<std::string,Vector> new_values_;///<Their new values
+    EnergyType deltas_;
+};
+
+} //End namespace FManII
@@ -21,6 +21,8 @@
 
 #pragma once
 #include "ForceManII/FManIIDefs.hpp"
+#include "ForceManII/Cell.hpp"
+#include <algorithm>
 
 namespace FManII {
 
@@ -28,7 +30,59 @@ struct InternalCoordinates{
     InternalCoordinates(const std::string& name_):
         name(name_){}
 
-    virtual Vector deriv(size_t order,const Vector& sys,const IVector& atoms)const=0;
+    virtual Vector deriv(size_t order,const Vector& sys,AtomTuple atoms)const=0;
+
+    /** \brief Computes the derivative of a coordinate in a periodic system
+     *
+     *  Each atom in \p atoms is replaced by its periodic image closest to the
+     *  atom before it, which for a chain of bonded atoms (or a pair) is the
+     *  minimum image convention.  The derivative with respect to an image is
+     *  the derivative with respect to the atom, so the result can be used as
+     *  is.
+     *
+     *  \param[in] cell The unit cell, if null no images are taken
+     */
+    Vector deriv(size_t order,const Vector& sys,AtomTuple atoms,
+                 const Cell* cell)const{
+        if(!cell)return deriv(order,sys,atoms);
+        const size_t n=atoms.size();
+        Vector images(3*n);
+        IVector image_atoms(n);
+        for(size_t i=0;i<n;++i)image_atoms[i]=i;
+        image_chain(sys,atoms,cell,images.data());
+        return deriv(order,images,image_atoms);
+    }
+
+    /** \brief The value of the coordinate, the same as deriv(0,...) but
+     *         without allocating
+     *
+     *  Used when only energies are needed, the built-in coordinates
+     *  override it.
+     */
+    virtual double value(const Vector& sys,AtomTuple atoms,
+                         const Cell* cell)const{
+        return deriv(0,sys,atoms,cell)[0];
+    }
+
+    /** \brief The positions of \p atoms, each replaced by its periodic image
+     *         closest to the atom before it (see deriv())
+     *
+     *  \param[out] out 3 elements per atom of \p atoms
+     */
+    static void image_chain(const Vector& sys,AtomTuple atoms,const Cell* cell,
+                            double* out){
+        for(size_t i=0;i<atoms.size();++i){
+            const double* qi=&sys[3*atoms[i]];
+            if(i==0 || !cell){
+                std::copy(qi,qi+3,out+3*i);
+                continue;
+            }
+            const double* qj=out+3*(i-1);
+            const std::array<double,3> dr=
+                cell->minimum_image({qi[0]-qj[0],qi[1]-qj[1],qi[2]-qj[2]});
+            for(size_t j=0;j<3;++j)out[3*i+j]=qj[j]+dr[j];
+        }
+    }
 
     ///The name of this internal coordinate
     const std::string name;
@@ -26,42 +26,45 @@ using namespace std;
 
 namespace FManII {
 
-inline Vector angle(const double* r1, const double* r2, const double* r3)
+void Angle::bond_deriv(size_t order,const array<double,3>& r12,
+                       const array<double,3>& r32,double* out)
 {
-   const array<double,3> r12=diff(r1,r2),r32=diff(r3,r2);
-   return {angle(r12,r32)};
-}
-
-inline Vector dangle(const double* r1,const double* r2, const double* r3)
-{
-    const array<double,3> r12=diff(r1,r2),r31=diff(r3,r1),r32=diff(r3,r2);
+    if(order==0){
+        out[0]=angle(r12,r32);
+        return;
+    }
+    const array<double,3> r31=diff(r32,r12);
     const array<double,3> n=cross(r12,r32);
     const double r12_d_r32=dot(r12,r32);
     const double magn=mag(n);
     const double tantheta=r12_d_r32/magn;//Actually 1 over tan(theta)
     const array<double,3> A=cross(r32,n),B=cross(n,r31),C=cross(n,r12);
     const double prefactor=1/(std::pow(magn,2)+std::pow(r12_d_r32,2));
-    return {prefactor*(tantheta*A[0]-r32[0]*magn),
-            prefactor*(tantheta*A[1]-r32[1]*magn),
-            prefactor*(tantheta*A[2]-r32[2]*magn),
-            prefactor*(tantheta*B[0]+(r12[0]+r32[0])*magn),
-            prefactor*(tantheta*B[1]+(r12[1]+r32[1])*magn),
-            prefactor*(tantheta*B[2]+(r12[2]+r32[2])*magn),
-            prefactor*(tantheta*C[0]-r12[0]*magn),
-            prefactor*(tantheta*C[1]-r12[1]*magn),
-            prefactor*(tantheta*C[2]-r12[2]*magn)
-    };
+    for(size_t i=0;i<3;++i){
+        out[i]=prefactor*(tantheta*A[i]-r32[i]*magn);
+        out[3+i]=prefactor*(tantheta*B[i]+(r12[i]+r32[i])*magn);
+        out[6+i]=prefactor*(tantheta*C[i]-r12[i]*magn);
+    }
 }
 
-Vector Angle::deriv(size_t deriv_i,const Vector& sys,const IVector& coord_i)const{
+Vector Angle::deriv(size_t deriv_i,const Vector& sys,AtomTuple coord_i)const{
     CHECK(deriv_i<2,"Higher order derivatives are not yet implemented!!!");
     const size_t atomi=coord_i[0],atomj=coord_i[1],atomk=coord_i[2];
     const double *q1=&(sys[atomi*3]),
                  *q2=&(sys[atomj*3]),
                  *q3=&(sys[atomk*3]);
-    if(deriv_i==0) return angle(q1,q2,q3);
-    if(deriv_i==1) return dangle(q1,q2,q3);
+    Vector rv(deriv_i==0?1:9);
+    bond_deriv(deriv_i,diff(q1,q2),diff(q3,q2),rv.data());
+    return rv;
 }
 
-} //End namespace FManII
+double Angle::value(const Vector& sys,AtomTuple coord_i,
+                    const Cell* cell)const{
+    std::array<double,9> q;
+    image_chain(sys,coord_i,cell,q.data());
+    double rv;
+    bond_deriv(0,diff(&q[0],&q[3]),diff(&q[6],&q[3]),&rv);
+    return rv;
+}
 
+} //End namespace FManII
@@ -28,7 +28,18 @@ namespace FManII {
 struct Angle: public InternalCoordinates {
     Angle():InternalCoordinates(IntCoord_t::ANGLE){}
 
-    Vector deriv(size_t deriv_i,const Vector& sys,const IVector& coord_i)const;
+    Vector deriv(size_t deriv_i,const Vector& sys,AtomTuple coord_i)const;
+    double value(const Vector& sys,AtomTuple coord_i,const Cell* cell)const;
+
+    /** \brief The angle among atoms 1, 2, and 3 (\p order 0) or its gradient
+     *         (\p order 1) from the vectors along its two bonds
+     *
+     *  \param[in] r12 The vector from atom 2 to atom 1, q1-q2
+     *  \param[in] r32 The vector from atom 2 to atom 3, q3-q2
+     *  \param[out] out Where the 1 (order 0) or 9 (order 1) elements go
+     */
+    static void bond_deriv(size_t order,const std::array<double,3>& r12,
+                           const std::array<double,3>& r32,double* out);
 };
 
 } //End namespace FManII
@@ -49,7 +49,7 @@ inline Vector d2_dist(const double* q1,const double* q2)
     return deriv;
 }
 
-Vector Distance::deriv(size_t deriv_i,const Vector& sys,const IVector& coord_i)const{
+Vector Distance::deriv(size_t deriv_i,const Vector& sys,AtomTuple coord_i)const{
     CHECK(deriv_i<3,"Higher order derivatives are not yet implemented!!!");
     const size_t atomi=coord_i[0],atomj=coord_i[1];
     const double* q1=&(sys[atomi*3]), *q2=&(sys[atomj*3]);
@@ -58,7 +58,7 @@ Vector Distance::deriv(size_t deriv_i,const Vector& sys,const IVector& coord_i)c
     if(deriv_i==2) return d2_dist(q1,q2);
 }
 
-Vector Pair13::deriv(size_t deriv_i,const Vector& sys,const IVector& coord_i)const{
+Vector Pair13::deriv(size_t deriv_i,const Vector& sys,AtomTuple coord_i)const{
     const Vector d=Distance::deriv(deriv_i,sys,{coord_i[0],coord_i[2]});
     CHECK(deriv_i<3,"Derivatives higher than 2 are NYI");
     if(deriv_i==0)return d;
@@ -85,5 +85,13 @@ Vector Pair13::deriv(size_t deriv_i,const Vector& sys,const IVector& coord_i)con
     }
 
 }
+
+double Distance::value(const Vector& sys,AtomTuple coord_i,
+                       const Cell* cell)const{
+    std::array<double,3*max_arity> q;
+    image_chain(sys,coord_i,cell,q.data());
+    return mag(diff(&q[0],&q[3*(coord_i.size()-1)]));
+}
+
 } //End namespace FManII
 
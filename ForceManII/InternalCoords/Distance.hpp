@@ -29,7 +29,9 @@ class Distance: public InternalCoordinates {
 public:
     Distance(const std::string& namein):
         InternalCoordinates(namein){}
-    Vector deriv(size_t deriv_i,const Vector& sys,const IVector& coord_i)const;
+    Vector deriv(size_t deriv_i,const Vector& sys,AtomTuple coord_i)const;
+    ///The distance between the first and last atoms
+    double value(const Vector& sys,AtomTuple coord_i,const Cell* cell)const;
 };
 
 class Bond:public Distance{
@@ -47,7 +49,7 @@ public:
 class Pair13: public Distance{
 public:
     Pair13():Distance(IntCoord_t::PAIR13){}
-    Vector deriv(size_t deriv_i,const Vector& sys,const IVector& coord_i)const;
+    Vector deriv(size_t deriv_i,const Vector& sys,AtomTuple coord_i)const;
 };
 
 class Pair14: public Distance{
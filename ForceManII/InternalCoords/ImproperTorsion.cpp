@@ -21,24 +21,49 @@
 #include "ForceManII/Common.hpp"
 #include <algorithm>//For std::rotate
 
+using DArray=std::array<double,3>;
+
 namespace FManII {
 
 
-Vector ImproperTorsion::deriv(size_t deriv_i,const Vector& sys,const IVector& coord_i)const{
-    std::array<size_t,3> atoms={coord_i[0],coord_i[2],coord_i[3]};
-    size_t NDims=(size_t)std::pow(12.0,deriv_i);
-    Vector phi(NDims,0.0);
-    Vector temp=
-    Torsion::deriv(deriv_i,sys,{atoms[0],coord_i[1],atoms[1],atoms[2]});
+void ImproperTorsion::bond_deriv(size_t order,const DArray& r21,
+                                 const DArray& r23,const DArray& r24,
+                                 double* out){
+    //Each term is a torsion with the central atom second, the other three
+    //atoms take turns being first
+    const size_t n=order==0?1:12;
+    std::array<const DArray*,3> rs={&r21,&r23,&r24};
+    double temp[12];
+    auto torsion=[&](){
+        Torsion::bond_deriv(order,*rs[0],*rs[1],diff(*rs[2],*rs[1]),temp);
+    };
+    torsion();
     if(temp[0]<0)//Take our angle to be positive (matters for harmonic description)
-        std::swap(atoms[1],atoms[2]);
-    do{
-        temp=
-        Torsion::deriv(deriv_i,sys,{atoms[0],coord_i[1],atoms[1],atoms[2]});
-        for(size_t i=0;i<NDims;++i)phi[i]+=(1.0/3.0)*temp[i];
-        std::rotate(atoms.begin(),atoms.begin()+1,atoms.end());
-    }while(*atoms.begin()!=coord_i[0]);
+        std::swap(rs[1],rs[2]);
+    std::fill(out,out+n,0.0);
+    for(size_t turn=0;turn<3;++turn){
+        torsion();
+        for(size_t i=0;i<n;++i)out[i]+=(1.0/3.0)*temp[i];
+        std::rotate(rs.begin(),rs.begin()+1,rs.end());
+    }
+}
+
+Vector ImproperTorsion::deriv(size_t deriv_i,const Vector& sys,AtomTuple coord_i)const{
+    CHECK(deriv_i<2,"Higher order derivatives are not yet implemented!!!");
+    const double *q1=&(sys[coord_i[0]*3]), *q2=&(sys[coord_i[1]*3]),
+                 *q3=&(sys[coord_i[2]*3]), *q4=&(sys[coord_i[3]*3]);
+    Vector phi(deriv_i==0?1:12);
+    bond_deriv(deriv_i,diff(q2,q1),diff(q2,q3),diff(q2,q4),phi.data());
     return phi;
 }
 
+double ImproperTorsion::value(const Vector& sys,AtomTuple coord_i,
+                              const Cell* cell)const{
+    std::array<double,12> q;
+    image_chain(sys,coord_i,cell,q.data());
+    double rv;
+    bond_deriv(0,diff(&q[3],&q[0]),diff(&q[3],&q[6]),diff(&q[3],&q[9]),&rv);
+    return rv;
+}
+
 } //End namespace FManII
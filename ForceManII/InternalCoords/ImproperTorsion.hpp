@@ -28,7 +28,21 @@ namespace FManII {
 ///See [Torsion Class](@ref torsion) for more detail.
 struct ImproperTorsion: public Torsion {
     ImproperTorsion():Torsion(IntCoord_t::IMPTORSION){}
-    Vector deriv(size_t deriv_i,const Vector& sys,const IVector& coord_i)const;
+    Vector deriv(size_t deriv_i,const Vector& sys,AtomTuple coord_i)const;
+    double value(const Vector& sys,AtomTuple coord_i,const Cell* cell)const;
+
+    /** \brief The improper torsion of atoms 1-4, with 2 the central atom,
+     *         (\p order 0) or its gradient (\p order 1) from the vectors
+     *         along its three bonds
+     *
+     *  \param[in] r21 q2-q1
+     *  \param[in] r23 q2-q3
+     *  \param[in] r24 q2-q4
+     *  \param[out] out Where the 1 (order 0) or 12 (order 1) elements go
+     */
+    static void bond_deriv(size_t order,const std::array<double,3>& r21,
+                           const std::array<double,3>& r23,
+                           const std::array<double,3>& r24,double* out);
 };
 
 
@@ -29,7 +29,20 @@ namespace FManII {
 struct Torsion: public InternalCoordinates {
     Torsion(const std::string& namein=IntCoord_t::TORSION):
         InternalCoordinates(namein){}
-    Vector deriv(size_t deriv_i,const Vector& sys,const IVector& coord_i)const;
+    Vector deriv(size_t deriv_i,const Vector& sys,AtomTuple coord_i)const;
+    double value(const Vector& sys,AtomTuple coord_i,const Cell* cell)const;
+
+    /** \brief The torsion angle of atoms 1-2-3-4 (\p order 0) or its gradient
+     *         (\p order 1) from the vectors along its three bonds
+     *
+     *  \param[in] r21 q2-q1
+     *  \param[in] r23 q2-q3
+     *  \param[in] r34 q3-q4
+     *  \param[out] out Where the 1 (order 0) or 12 (order 1) elements go
+     */
+    static void bond_deriv(size_t order,const std::array<double,3>& r21,
+                           const std::array<double,3>& r23,
+                           const std::array<double,3>& r34,double* out);
 };
 
 
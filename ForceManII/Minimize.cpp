@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "ForceManII/Minimize.hpp"
+#include "ForceManII/Common.hpp"
+#include "ForceManII/Profile.hpp"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+using namespace std;
+namespace FManII {
+
+//Fraction of the predicted decrease a line search must achieve
+constexpr double armijo=1e-4;
+
+inline double dot(const Vector& a,const Vector& b){
+    double rv=0.0;
+    for(size_t i=0;i<a.size();++i)rv+=a[i]*b[i];
+    return rv;
+}
+
+//The energy and gradient at carts
+inline void evaluate(EvaluationPlan& plan,const Vector& carts,
+                     MinimizeResult& rv){
+    rv.carts=carts;
+    rv.grad.assign(carts.size(),0.0);
+    plan.add_gradient(carts,rv.grad,&rv.energies);
+    rv.energy=0.0;
+    for(const auto& ei:rv.energies)rv.energy+=ei.second;
+}
+
+inline bool grad_converged(const Vector& grad,const MinimizeOptions& opts){
+    double max_g=0.0;
+    for(double gi:grad)max_g=std::max(max_g,std::fabs(gi));
+    const double rms=grad.empty()?0.0:std::sqrt(dot(grad,grad)/grad.size());
+    return rms<opts.grad_rms && max_g<opts.grad_max;
+}
+
+//One step of L-BFGS history, s is the step and y the change in gradient
+struct LBFGSStep{
+    Vector s,y;
+    double rho;
+};
+
+//The L-BFGS direction, -H*grad, from the two loop recursion
+inline Vector direction(const Vector& grad,const deque<LBFGSStep>& history){
+    Vector d(grad);
+    Vector alpha(history.size());
+    for(size_t k=history.size();k-->0;){
+        const LBFGSStep& u=history[k];
+        alpha[k]=u.rho*dot(u.s,d);
+        for(size_t i=0;i<d.size();++i)d[i]-=alpha[k]*u.y[i];
+    }
+    if(!history.empty()){
+        const LBFGSStep& u=history.back();
+        const double gamma=dot(u.s,u.y)/dot(u.y,u.y);
+        for(double& di:d)di*=gamma;
+    }
+    for(size_t k=0;k<history.size();++k){
+        const LBFGSStep& u=history[k];
+        const double beta=u.rho*dot(u.y,d);
+        for(size_t i=0;i<d.size();++i)d[i]+=(alpha[k]-beta)*u.s[i];
+    }
+    for(double& di:d)di=-di;
+    return d;
+}
+
+MinimizeResult minimize(EvaluationPlan& plan,
+                        const Vector& carts,
+                        const MinimizeOptions& options){
+    FMANII_TIMER(timer);
+    CHECK(options.history>0,"L-BFGS needs a history of at least one step");
+    CHECK(options.max_step>0.0,"The largest step must be positive");
+    CHECK(options.max_line_steps>0,"Line searches need at least one step");
+    MinimizeResult rv,trial;
+    evaluate(plan,carts,rv);
+    size_t nevals=1;
+    deque<LBFGSStep> history;
+    while(!(rv.converged=grad_converged(rv.grad,options)) &&
+          rv.nsteps<options.max_steps){
+        Vector d=direction(rv.grad,history);
+        double slope=dot(rv.grad,d);
+        if(slope>=0.0){//Not downhill, start over
+            history.clear();
+            d=rv.grad;
+            for(double& di:d)di=-di;
+            slope=dot(rv.grad,d);
+        }
+        double longest=0.0;
+        for(double di:d)longest=std::max(longest,std::fabs(di));
+        if(longest>options.max_step){
+            const double scale=options.max_step/longest;
+            for(double& di:d)di*=scale;
+            slope*=scale;
+        }
+
+        bool accepted=false;
+        double step=1.0;
+        Vector x(carts.size());
+        for(size_t ls=0;ls<options.max_line_steps && !accepted;++ls,step/=2){
+            for(size_t i=0;i<x.size();++i)x[i]=rv.carts[i]+step*d[i];
+            evaluate(plan,x,trial);
+            ++nevals;
+            accepted=trial.energy<=rv.energy+armijo*step*slope;
+        }
+        if(!accepted){
+            if(history.empty())break;//Steepest descent failed too
+            history.clear();
+            continue;
+        }
+
+        LBFGSStep u;
+        u.s.resize(x.size());
+        u.y.resize(x.size());
+        for(size_t i=0;i<x.size();++i){
+            u.s[i]=trial.carts[i]-rv.carts[i];
+            u.y[i]=trial.grad[i]-rv.grad[i];
+        }
+        const double sy=dot(u.s,u.y);
+        //Only keep updates that leave the inverse Hessian positive definite
+        if(sy>1e-12*std::sqrt(dot(u.s,u.s)*dot(u.y,u.y))){
+            u.rho=1.0/sy;
+            history.push_back(move(u));
+            if(history.size()>options.history)history.pop_front();
+        }
+        const double change=rv.energy-trial.energy;
+        trial.nsteps=rv.nsteps+1;
+        swap(rv,trial);
+        if(options.energy_change>0.0 && change<options.energy_change){
+            rv.converged=true;
+            break;
+        }
+    }
+    //The plan may have been left at a rejected trial geometry
+    plan.set_coords(rv.carts);
+    rv.nevals=nevals;
+    FMANII_TRACE(timer,"minimize","phase",rv.nsteps);
+    return rv;
+}
+
+} //End namespace FManII
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+#include "ForceManII/EvaluationPlan.hpp"
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+
+///When and how minimize() takes its steps, all in atomic units
+struct MinimizeOptions{
+    size_t max_steps=1000;///<The most steps to take
+    double grad_rms=3e-4;///<Converged once the RMS gradient is below this...
+    double grad_max=4.5e-4;///<...and the largest gradient component this
+    ///Also converged if the energy changes by less than this in a step, 0 to
+    ///only use the gradient
+    double energy_change=0.0;
+    size_t history=8;///<How many steps L-BFGS remembers
+    double max_step=0.3;///<The most any coordinate may move in one step
+    size_t max_line_steps=20;///<The most energies a line search may compute
+};
+
+///What minimize() found
+struct MinimizeResult{
+    Vector carts;///<The final geometry
+    Vector grad;///<The gradient at carts
+    EnergyType energies;///<The energy of each term at carts
+    double energy=0.0;///<The total energy at carts
+    size_t nsteps=0;///<How many steps were taken
+    size_t nevals=0;///<How many times the energy and gradient were computed
+    bool converged=false;///<True if the criteria of the options were met
+};
+
+/** \brief Minimizes the energy of a system with L-BFGS
+ *
+ *  Each step is along the L-BFGS direction, limited so no coordinate moves
+ *  more than MinimizeOptions::max_step, and then a backtracking line search
+ *  halves it until the energy drops enough (the Armijo condition).  Every
+ *  evaluation is one call to EvaluationPlan::add_gradient(), so nothing is
+ *  set up again.  If the line search fails, the history is discarded and
+ *  steepest descent is tried before giving up.
+ *
+ *  \param[in,out] plan The system, left at the final geometry
+ *  \param[in] carts The starting geometry (caller's numbering, a.u.)
+ */
+MinimizeResult minimize(EvaluationPlan& plan,
+                        const Vector& carts,
+                        const MinimizeOptions& options=MinimizeOptions());
+
+} //End namespace FManII
@@ -19,6 +19,7 @@
 
 #include "ForceManII/ModelPotentials/FourierSeries.hpp"
 #include "ForceManII/Common.hpp"
+#include <array>
 #include <cmath>
 
 namespace FManII{
@@ -34,6 +35,43 @@ inline double even_deriv_(size_t d,double Q, double Q0, double V, double n){
     return (d/2%2==0?de:-1*de);
 }
 
+//Largest periodicity the recurrence is used for
+constexpr size_t max_n_=12;
+
+//The sign of cos(nQ-phi) relative to cos(nQ) if phi is 0 or 180 degrees, 0
+//if it's neither
+inline double phase_sign_(double phi){
+    if(std::fabs(phi)<1e-10)return 1.0;
+    if(std::fabs(std::fabs(phi)-M_PI)<1e-10)return -1.0;
+    return 0.0;
+}
+
+//True if n is an integer the recurrence can handle
+inline bool small_int_(double n){
+    return n>=0.0 && n<=max_n_ && n==std::floor(n);
+}
+
+//cos(kQ) and sin(kQ) for one coordinate, extended as needed with the
+//Chebyshev recurrence cos(kQ)=2cos(Q)cos((k-1)Q)-cos((k-2)Q) (same for sin)
+struct Multiples_{
+    std::array<double,max_n_+1> c,s;
+    const double Q;
+    size_t nbuilt=0;
+    explicit Multiples_(double Qin):Q(Qin){
+        c[0]=1.0;s[0]=0.0;
+    }
+    void extend(size_t n){
+        if(n>0 && nbuilt==0){
+            c[1]=std::cos(Q);s[1]=std::sin(Q);
+            nbuilt=1;
+        }
+        for(;nbuilt<n;++nbuilt){
+            c[nbuilt+1]=2.0*c[1]*c[nbuilt]-c[nbuilt-1];
+            s[nbuilt+1]=2.0*c[1]*s[nbuilt]-s[nbuilt-1];
+        }
+    }
+};
+
 }//End detail
 
 Vector FourierSeries::deriv(size_t order,
@@ -55,8 +93,23 @@ Vector FourierSeries::deriv(size_t order,
     const size_t NElems=(size_t)std::pow(N,order);
     Vector return_value(NElems,0.0);
     for(size_t i=0;i<N;++i){
+        detail::Multiples_ mult(Qs[i]);
         for(size_t j=0;j<dim;++j){
             const size_t idx=i*dim+j;
+            const double sign=detail::phase_sign_(phis[idx]);
+            if(sign!=0.0 && detail::small_int_(ns[idx])){
+                //cos(nQ-phi)=sign*cos(nQ), sin(nQ-phi)=sign*sin(nQ)
+                const size_t n=static_cast<size_t>(ns[idx]);
+                const double V=sign*Vs[idx];
+                mult.extend(n);
+                if(order==0)
+                    return_value[0]+=Vs[idx]+(n==0?0.0:V*mult.c[n]);
+                else if(order==1)
+                    return_value[i]-=V*n*mult.s[n];
+                else if(order==2)
+                    return_value[i*N+i]-=V*n*n*mult.c[n];
+                continue;
+            }
             if(order==0)
                 return_value[0]+=Vs[idx]+
                         detail::even_deriv_(0,Qs[i],phis[idx],Vs[idx],ns[idx]);
@@ -27,6 +27,7 @@ Vector LennardJones::deriv(size_t order,
               const ParamInput_t &in_params,
               const CoordInput_t &in_coords)const
 {
+    if(in_params.count(Param_t::A))return deriv_AB(order,in_params,in_coords);
     const Vector &Qs=in_coords[0],
                  &ss=in_params.at(FManII::Param_t::sigma),
                  &es=in_params.at(FManII::Param_t::epsilon);
@@ -58,4 +59,33 @@ Vector LennardJones::deriv(size_t order,
     return d;
 }
 
+Vector LennardJones::deriv_AB(size_t order,
+              const ParamInput_t &in_params,
+              const CoordInput_t &in_coords)const
+{
+    const Vector &Qs=in_coords[0],
+                 &As=in_params.at(FManII::Param_t::A),
+                 &Bs=in_params.at(FManII::Param_t::B);
+    const size_t n=Qs.size();
+    DEBUG_CHECK(As.size()==n,"len(Qs) != len(As)");
+    DEBUG_CHECK(Bs.size()==n,"len(Qs) != len(Bs)");
+    std::vector<double> d(static_cast<size_t>(std::pow(n,order)),0.0);
+    if(order==0)
+        for(size_t i=0;i<n;++i){
+            const double inv2=1.0/(Qs[i]*Qs[i]),inv6=inv2*inv2*inv2;
+            d[0]+=(As[i]*inv6-Bs[i])*inv6;
+        }
+    else if(order==1)
+        for(size_t i=0;i<n;++i){
+            const double inv2=1.0/(Qs[i]*Qs[i]),inv6=inv2*inv2*inv2;
+            d[i]+=(6.0*Bs[i]-12.0*As[i]*inv6)*inv6*inv2*Qs[i];
+        }
+    else if(order==2)
+        for(size_t i=0;i<n;++i){
+            const double inv2=1.0/(Qs[i]*Qs[i]),inv6=inv2*inv2*inv2;
+            d[i*n+i]+=(156.0*As[i]*inv6-42.0*Bs[i])*inv6*inv2;
+        }
+    return d;
+}
+
 }//End namespace
@@ -36,6 +36,10 @@ struct LennardJones: public ModelPotential{
          *
          *  \note This function expects all quantities to be in atomic units
          *
+         *  \note If \p in_params contains Param_t::A and Param_t::B (as the
+         *        parameters from assign_params do) the potential is evaluated
+         *        as A/r^12-B/r^6 and the sigmas and epsilons are not needed
+         *
          *  \param[in] order What order derivative are we returning?
          *  \param[in] in_params the sigmas and the epsilons
          *  \param[in] in_coords the value of the internal coordinates
@@ -46,6 +50,11 @@ struct LennardJones: public ModelPotential{
         Vector deriv(size_t order,
                      const ParamInput_t& in_params,
                      const CoordInput_t& in_coords)const;
+private:
+        ///Implements deriv when the parameters are A and B
+        Vector deriv_AB(size_t order,
+                        const ParamInput_t& in_params,
+                        const CoordInput_t& in_coords)const;
 };
 
 } //End namespace FManII
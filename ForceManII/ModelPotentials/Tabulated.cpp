@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "ForceManII/ModelPotentials/Tabulated.hpp"
+#include "ForceManII/Common.hpp"
+#include "ForceManII/FManII.hpp"
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+using namespace std;
+namespace FManII{
+
+size_t Tabulated::ParamHash::operator()(const Vector& ps)const{
+    size_t seed=ps.size();
+    for(double p:ps)
+        seed^=hash<double>()(p)+0x9e3779b9+(seed<<6)+(seed>>2);
+    return seed;
+}
+
+Tabulated::Tabulated(shared_ptr<const ModelPotential> model,
+                     size_t npoints,
+                     double rmin,
+                     double rmax,
+                     const vector<string>& linear_params):
+    ModelPotential(model->params,model->name),
+    model_(move(model)),
+    npoints_(npoints),
+    rmin_(rmin),
+    rmax_(rmax),
+    r2min_(rmin*rmin),
+    h_((rmax*rmax-rmin*rmin)/(npoints>1?npoints-1:1)),
+    linear_(linear_params)
+{
+    CHECK(npoints_>1,"Tables need at least two points");
+    CHECK(0.0<rmin_ && rmin_<rmax_,"Table range must satisfy 0 < rmin < rmax");
+}
+
+size_t Tabulated::ntables()const{
+    lock_guard<mutex> lock(mutex_);
+    return tables_.size();
+}
+
+bool Tabulated::is_linear(const vector<string>& names)const{
+    if(names.empty()||linear_.empty())return false;
+    for(const string& name:names)
+        if(find(linear_.begin(),linear_.end(),name)==linear_.end())
+            return false;
+    return true;
+}
+
+unique_ptr<const Tabulated::Table>
+Tabulated::make_table(const ParamInput_t& ps)const{
+    const size_t nfxns=ps.begin()->second.size();
+    unique_ptr<Table> t=make_unique<Table>();
+    t->nfxns=nfxns;
+    t->c.assign(4*nfxns*(npoints_-1),0.0);
+    ParamInput_t p1;
+    for(const auto& pi:ps)p1[pi.first]=Vector(1);
+    CoordInput_t r1(1,Vector(1));
+    Vector f(npoints_),df(npoints_);
+    for(size_t fi=0;fi<nfxns;++fi){
+        for(const auto& pi:ps)p1[pi.first][0]=pi.second[fi];
+        for(size_t k=0;k<npoints_;++k){
+            const double r=std::sqrt(r2min_+k*h_);
+            r1[0][0]=r;
+            f[k]=model_->deriv(0,p1,r1)[0];
+            //Chain rule, dE/d(r^2)=dE/dr/(2r)
+            df[k]=model_->deriv(1,p1,r1)[0]/(2.0*r);
+        }
+        //Cubic Hermite coefficients in terms of u=(r^2-r_k^2)/h
+        for(size_t k=0;k+1<npoints_;++k){
+            double* c=&t->c[4*(k*nfxns+fi)];
+            c[0]=f[k];
+            c[1]=h_*df[k];
+            c[2]=3.0*(f[k+1]-f[k])-h_*(2.0*df[k]+df[k+1]);
+            c[3]=2.0*(f[k]-f[k+1])+h_*(df[k]+df[k+1]);
+        }
+    }
+    return unique_ptr<const Table>(move(t));
+}
+
+//Assumes mutex_ is held
+const Tabulated::Table* Tabulated::find_table(const vector<string>& names,
+                                              const Vector& key)const{
+    TableMap& tmap=table_index_[names];
+    auto ti=tmap.find(key);
+    if(ti!=tmap.end())return tables_[ti->second].get();
+    //The linear tables have an empty key and one function per parameter,
+    //the one the parameter is 1 in and all others are 0 in
+    ParamInput_t ps;
+    for(size_t i=0;i<names.size();++i){
+        if(!key.empty())ps[names[i]]=Vector(1,key[i]);
+        else{
+            ps[names[i]]=Vector(names.size(),0.0);
+            ps[names[i]][i]=1.0;
+        }
+    }
+    tables_.push_back(make_table(ps));
+    tmap[key]=tables_.size()-1;
+    return tables_.back().get();
+}
+
+vector<const Tabulated::Table*>
+Tabulated::tables(const ParamInput_t& in_params,size_t n,Vector& weights)const{
+    vector<string> names;
+    for(const auto& pi:in_params){
+        CHECK(pi.second.size()==n,"Tabulated models need one "+pi.first+
+              " per pair");
+        names.push_back(pi.first);
+    }
+    CHECK(!names.empty(),"Tabulated models need parameters");
+    const size_t m=names.size();
+    lock_guard<mutex> lock(mutex_);
+    if(is_linear(names)){
+        weights.resize(n*m);
+        for(size_t i=0;i<m;++i){
+            const Vector& ps=in_params.at(names[i]);
+            for(size_t k=0;k<n;++k)weights[k*m+i]=ps[k];
+        }
+        return vector<const Table*>(n,find_table(names,Vector()));
+    }
+    weights.assign(n,1.0);
+    vector<const Table*> rv(n);
+    Vector key(m);
+    for(size_t k=0;k<n;++k){
+        for(size_t i=0;i<m;++i)key[i]=in_params.at(names[i])[k];
+        rv[k]=find_table(names,key);
+    }
+    return rv;
+}
+
+double Tabulated::interpolate(const Table& t,const double* w,double r,
+                              size_t order)const{
+    const double r2=r*r,x=(r2-r2min_)/h_;
+    const size_t i=std::min(static_cast<size_t>(x),npoints_-2);
+    const double u=x-i;
+    const double* c=&t.c[4*i*t.nfxns];
+    double f=0.0,df=0.0,d2f=0.0;
+    for(size_t fi=0;fi<t.nfxns;++fi,c+=4){
+        if(order==0)f+=w[fi]*(c[0]+u*(c[1]+u*(c[2]+u*c[3])));
+        else df+=w[fi]*(c[1]+u*(2.0*c[2]+3.0*u*c[3]));
+        if(order==2)d2f+=w[fi]*(2.0*c[2]+6.0*u*c[3]);
+    }
+    if(order==0)return f;
+    if(order==1)return 2.0*r*df/h_;
+    return 2.0*df/h_+4.0*r2*d2f/(h_*h_);
+}
+
+Vector Tabulated::deriv(size_t order,
+                        const ParamInput_t& in_params,
+                        const CoordInput_t& in_coords)const
+{
+    const Vector& Qs=in_coords[0];
+    const size_t n=Qs.size();
+    DEBUG_CHECK(order<=2,"Derivatives larger than order 2 are not coded");
+    Vector d(static_cast<size_t>(std::pow(n,order)),0.0);
+    if(!n)return d;
+    Vector w;
+    const vector<const Table*> tabs=tables(in_params,n,w);
+    IVector close;//Pairs too close for the table
+    for(size_t k=0;k<n;++k){
+        if(Qs[k]>=rmax_)continue;
+        if(Qs[k]<rmin_){
+            close.push_back(k);
+            continue;
+        }
+        const double v=interpolate(*tabs[k],&w[k*tabs[k]->nfxns],Qs[k],order);
+        if(order==0)d[0]+=v;
+        else if(order==1)d[k]=v;
+        else d[k*n+k]=v;
+    }
+    if(close.empty())return d;
+
+    const size_t nclose=close.size();
+    ParamInput_t ps;
+    for(const auto& pi:in_params)
+        for(size_t k:close)ps[pi.first].push_back(pi.second[k]);
+    CoordInput_t cs(1);
+    for(size_t k:close)cs[0].push_back(Qs[k]);
+    const Vector sub=model_->deriv(order,ps,cs);
+    if(order==0)d[0]+=sub[0];
+    else if(order==1)
+        for(size_t a=0;a<nclose;++a)d[close[a]]=sub[a];
+    else
+        for(size_t a=0;a<nclose;++a)
+            for(size_t b=0;b<nclose;++b)
+                d[close[a]*n+close[b]]=sub[a*nclose+b];
+    return d;
+}
+
+TableAccuracy Tabulated::accuracy(const ParamInput_t& in_params,
+                                  size_t nsamples)const{
+    CHECK(nsamples>0,"Need at least one sample");
+    CHECK(!in_params.empty(),"Tabulated models need parameters");
+    const size_t n=in_params.begin()->second.size();
+    set<Vector> unique_ps;
+    for(size_t k=0;k<n;++k){
+        Vector key;
+        for(const auto& pi:in_params)key.push_back(pi.second.at(k));
+        unique_ps.insert(key);
+    }
+
+    TableAccuracy rv;
+    double egy_err2=0.0,grad_err2=0.0;
+    ParamInput_t p1;
+    for(const auto& pi:in_params)p1[pi.first]=Vector(1);
+    CoordInput_t r1(1,Vector(1));
+    for(const Vector& key:unique_ps){
+        size_t i=0;
+        for(auto& pi:p1)pi.second[0]=key[i++];
+        for(size_t s=0;s<nsamples;++s){
+            r1[0][0]=rmin_+(rmax_-rmin_)*s/nsamples;
+            const double e=model_->deriv(0,p1,r1)[0],
+                         g=model_->deriv(1,p1,r1)[0],
+                         de=std::fabs(deriv(0,p1,r1)[0]-e),
+                         dg=std::fabs(deriv(1,p1,r1)[0]-g);
+            rv.max_egy_error=std::max(rv.max_egy_error,de);
+            rv.max_grad_error=std::max(rv.max_grad_error,dg);
+            if(e!=0.0)
+                rv.max_rel_egy_error=
+                        std::max(rv.max_rel_egy_error,de/std::fabs(e));
+            if(g!=0.0)
+                rv.max_rel_grad_error=
+                        std::max(rv.max_rel_grad_error,dg/std::fabs(g));
+            egy_err2+=de*de;
+            grad_err2+=dg*dg;
+            ++rv.nsamples;
+        }
+    }
+    if(rv.nsamples){
+        rv.rms_egy_error=std::sqrt(egy_err2/rv.nsamples);
+        rv.rms_grad_error=std::sqrt(grad_err2/rv.nsamples);
+    }
+    return rv;
+}
+
+void tabulate_nonbonded(ForceField& ff,size_t npoints,double rmin,double rmax){
+    for(auto& ti:ff.terms){
+        const string& model=ti.first.first;
+        if(model!=Model_t::LENNARD_JONES && model!=Model_t::ELECTROSTATICS)
+            continue;
+        if(dynamic_cast<const Tabulated*>(&ti.second.model()))continue;
+        const vector<string> linear=model==Model_t::LENNARD_JONES?
+                    vector<string>({Param_t::A,Param_t::B}):
+                    vector<string>({Param_t::q});
+        ti.second=FFTerm(make_shared<Tabulated>(get_potential(model),npoints,
+                                                rmin,rmax,linear),
+                         get_intcoord(ti.first.second));
+    }
+}
+
+}//End namespace
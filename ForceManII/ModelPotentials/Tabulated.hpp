@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+
+#include "ForceManII/ModelPotential.hpp"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+class ForceField;
+
+///How well a Tabulated potential reproduces the analytic one
+struct TableAccuracy{
+    size_t nsamples=0;///<The number of distances compared
+    double max_egy_error=0.0;///<Largest absolute error in the energy
+    double max_grad_error=0.0;///<Largest absolute error in dE/dr
+    double max_rel_egy_error=0.0;///<Largest error in the energy over |E|
+    double max_rel_grad_error=0.0;///<Largest error in dE/dr over |dE/dr|
+    double rms_egy_error=0.0;///<Root-mean-square error in the energy
+    double rms_grad_error=0.0;///<Root-mean-square error in dE/dr
+};
+
+/** \brief A pair potential interpolated from cubic-spline tables
+ *
+ * See [Tabulated Potentials](@ref tabulated) for details regarding conventions
+ * etc.
+ */
+struct Tabulated: public ModelPotential{
+
+    /** \brief Makes a tabulated version of a pair potential
+     *
+     *  The resulting model has the same name and parameters as \p model, so
+     *  it can replace it in a ForceField without changing how parameters are
+     *  assigned or how the results are labeled.
+     *
+     *  \param[in] model The analytic potential, it must depend only on the
+     *                   distance and have one set of parameters per pair
+     *  \param[in] npoints The number of knots in each table
+     *  \param[in] rmin Shorter distances are computed analytically
+     *  \param[in] rmax The cutoff, longer distances contribute nothing
+     *  \param[in] linear_params Parameters the model is linear in.  When all
+     *                   of the parameters given to deriv() are in this list,
+     *                   one table per parameter is shared by all pairs instead
+     *                   of building one table per distinct set of parameters.
+     */
+    Tabulated(std::shared_ptr<const ModelPotential> model,
+              size_t npoints=4096,
+              double rmin=1.0,
+              double rmax=20.0,
+              const std::vector<std::string>& linear_params={});
+
+    /** Computes the derivative of the energy by interpolation
+     *
+     *  \note This function expects all quantities to be in atomic units
+     *
+     *  \param[in] order What order derivative are we returning?
+     *  \param[in] in_params the parameters of the analytic model
+     *  \param[in] in_coords the distances
+     *
+     *  \return The derivative in atomic units.
+     */
+    Vector deriv(size_t order,
+                 const ParamInput_t& in_params,
+                 const CoordInput_t& in_coords)const;
+
+    /** \brief Compares the tables to the analytic potential
+     *
+     *  For each distinct set of parameters in \p in_params the energy and its
+     *  derivative are computed on \p nsamples distances evenly spread between
+     *  rmin and rmax, both ways.
+     */
+    TableAccuracy accuracy(const ParamInput_t& in_params,
+                           size_t nsamples=10000)const;
+
+    ///The analytic model being interpolated
+    const ModelPotential& model()const{return *model_;}
+
+    ///The number of tables built so far
+    size_t ntables()const;
+
+    ///The cutoff, past it the potential is zero
+    double rmax()const{return rmax_;}
+
+private:
+    ///The spline coefficients of one or more functions sharing knots
+    struct Table{
+        size_t nfxns;///<The number of functions tabulated
+        Vector c;///<4 coefficients per function per interval
+    };
+
+    ///Hashes a set of parameters
+    struct ParamHash{
+        size_t operator()(const Vector& ps)const;
+    };
+    using TableMap=std::unordered_map<Vector,size_t,ParamHash>;
+
+    std::shared_ptr<const ModelPotential> model_;
+    const size_t npoints_;
+    const double rmin_,rmax_,r2min_,h_;
+    const std::vector<std::string> linear_;
+
+    ///Tables built so far, never removed so pointers to them stay valid
+    mutable std::vector<std::unique_ptr<const Table>> tables_;
+    ///Which table goes with which parameters, for each set of parameter names
+    mutable std::map<std::vector<std::string>,TableMap> table_index_;
+    mutable std::mutex mutex_;
+
+    ///True if pairs with these parameters share the linear tables
+    bool is_linear(const std::vector<std::string>& names)const;
+
+    ///Returns the table for each pair and what to multiply each of its
+    ///functions by, building the missing tables
+    std::vector<const Table*> tables(const ParamInput_t& in_params,size_t n,
+                                     Vector& weights)const;
+
+    ///Returns the table that goes with \p key, making it if needed
+    const Table* find_table(const std::vector<std::string>& names,
+                            const Vector& key)const;
+
+    ///Tabulates the model for each set of parameters in \p ps
+    std::unique_ptr<const Table> make_table(const ParamInput_t& ps)const;
+
+    ///Interpolates the order-th derivative with respect to r of one pair
+    double interpolate(const Table& t,const double* w,double r,
+                       size_t order)const;
+};
+
+/** \brief Replaces the Lennard-Jones and electrostatics models of a force
+ *         field with Tabulated versions
+ *
+ *  The remaining arguments are forwarded to Tabulated's constructor.
+ */
+void tabulate_nonbonded(ForceField& ff,
+                        size_t npoints=4096,
+                        double rmin=1.0,
+                        double rmax=20.0);
+
+} //End namespace FManII
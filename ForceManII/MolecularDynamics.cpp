@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "ForceManII/MolecularDynamics.hpp"
+#include "ForceManII/Common.hpp"
+#include "ForceManII/FManII.hpp"
+#include "ForceManII/ModelPotentials/Tabulated.hpp"
+#include "ForceManII/Profile.hpp"
+#include "ForceManII/Util.hpp"
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+namespace FManII {
+
+MolecularDynamics::MolecularDynamics(const EvaluationPlan& plan,
+                                     const Vector& carts,
+                                     const Vector& masses,
+                                     const MDOptions& options):
+    plan_(plan),
+    opts_(options),
+    carts_(plan.to_internal(carts)),
+    v_(carts_.size(),0.0),
+    mol_(plan.molecule()),
+    ps_(plan.params()),
+    rng_(options.seed)
+{
+    CHECK(masses.size()==plan_.natoms(),"Need one mass per atom");
+    CHECK(opts_.timestep>0.0,"The time step must be positive");
+    CHECK(opts_.coupling>0.0 && opts_.friction>=0.0,
+          "Thermostat settings must be positive");
+    CHECK(opts_.cutoff>=0.0 && opts_.skin>0.0,
+          "The cutoff can't be negative and the skin must be positive");
+    if(opts_.cutoff>0.0)
+        for(const auto& pi:ps_){
+            if(pi.first.second!=IntCoord_t::PAIR)continue;
+            const Tabulated* tab=dynamic_cast<const Tabulated*>(
+                &plan_.force_field().terms.at(pi.first).model());
+            CHECK(tab && tab->rmax()<=opts_.cutoff,
+                  pi.first.first+" must be zero past the cutoff, use "
+                  "tabulate_nonbonded() with rmax no larger than it");
+        }
+    Vector m3(carts_.size());
+    for(size_t i=0;i<masses.size();++i){
+        CHECK(masses[i]>0.0,"Atom "+to_string(i)+" has no mass");
+        for(size_t x=0;x<3;++x)m3[3*i+x]=masses[i];
+    }
+    masses_=plan_.to_internal(m3);
+    if(opts_.constraints!=Constraints::NONE){
+        Vector m(masses.size());
+        for(size_t i=0;i<m.size();++i)m[i]=masses_[3*i];
+        cons_=BondConstraints(plan_.molecule(),plan_.params(),m,
+                              opts_.constraints==Constraints::H_BONDS,
+                              opts_.constraint_tol);
+        const Vector start=carts_;
+        cons_.shake(start,carts_);
+    }
+    forces();
+}
+
+void MolecularDynamics::build_list(){
+    list_carts_=carts_;
+    ++nbuilds_;
+    const AtomTuples& all=plan_.molecule().atom_numbers.at(IntCoord_t::PAIR);
+    const size_t n=all.size();
+    if(!n)return;
+    const double r=opts_.cutoff+opts_.skin;
+    const Cell* cell=mol_.cell.get();
+    const Index_t* atoms=all.data().data();
+    IVector keep;
+    for(size_t k=0;k<n;++k){
+        array<double,3> dr=diff(&carts_[3*atoms[2*k]],&carts_[3*atoms[2*k+1]]);
+        if(cell)dr=cell->minimum_image(dr);
+        if(dot(dr,dr)<r*r)keep.push_back(k);
+    }
+    AtomTuples pairs(2);
+    pairs.reserve(keep.size());
+    for(size_t k:keep)pairs.push_back(all[k]);
+    mol_.atom_numbers[IntCoord_t::PAIR]=move(pairs);
+    mol_.coords[IntCoord_t::PAIR].assign(keep.size(),0.0);
+    for(auto& pi:ps_){
+        if(pi.first.second!=IntCoord_t::PAIR)continue;
+        for(auto& param:pi.second){
+            const Vector& full=plan_.params().at(pi.first).at(param.first);
+            const size_t stride=full.size()/n;
+            param.second.clear();
+            for(size_t k:keep)
+                param.second.insert(param.second.end(),
+                                    full.begin()+stride*k,
+                                    full.begin()+stride*(k+1));
+        }
+    }
+}
+
+void MolecularDynamics::forces(){
+    if(opts_.cutoff>0.0 && mol_.atom_numbers.count(IntCoord_t::PAIR)){
+        bool rebuild=list_carts_.empty();
+        const double half=opts_.skin/2.0;
+        for(size_t i=0;i<carts_.size() && !rebuild;i+=3){
+            const array<double,3> dr=diff(&carts_[i],&list_carts_[i]);
+            rebuild=dot(dr,dr)>half*half;
+        }
+        if(rebuild)build_list();
+    }
+    update_coords(mol_,carts_);
+    grad_.assign(carts_.size(),0.0);
+    add_gradient(plan_.force_field(),ps_,mol_,grad_,&egys_);
+}
+
+void MolecularDynamics::set_temperature(double T){
+    CHECK(T>=0.0,"Temperatures can't be negative");
+    const size_t natoms=plan_.natoms();
+    array<double,3> p={{0.0,0.0,0.0}};
+    double mtotal=0.0;
+    for(size_t i=0;i<natoms;++i){
+        const double m=masses_[3*i],sigma=std::sqrt(kB_au*T/m);
+        for(size_t x=0;x<3;++x){
+            v_[3*i+x]=sigma*gauss_(rng_);
+            p[x]+=m*v_[3*i+x];
+        }
+        mtotal+=m;
+    }
+    for(size_t i=0;i<natoms;++i)
+        for(size_t x=0;x<3;++x)v_[3*i+x]-=p[x]/mtotal;
+    cons_.rattle(carts_,v_);
+    const double current=temperature();
+    if(current>0.0)
+        for(double& vi:v_)vi*=std::sqrt(T/current);
+}
+
+void MolecularDynamics::set_velocities(const Vector& v){
+    CHECK(v.size()==carts_.size(),"Need 3 velocities per atom");
+    v_=plan_.to_internal(v);
+    cons_.rattle(carts_,v_);
+}
+
+double MolecularDynamics::potential_energy()const{
+    double rv=0.0;
+    for(const auto& ei:egys_)rv+=ei.second;
+    return rv;
+}
+
+double MolecularDynamics::kinetic_energy()const{
+    double rv=0.0;
+    for(size_t i=0;i<v_.size();++i)rv+=masses_[i]*v_[i]*v_[i];
+    return rv/2.0;
+}
+
+double MolecularDynamics::temperature()const{
+    const size_t ndof=v_.size()-cons_.size();
+    return ndof?2.0*kinetic_energy()/(ndof*kB_au):0.0;
+}
+
+void MolecularDynamics::output(ostream* energies,ostream* traj)const{
+    if(energies){
+        const double pe=potential_energy(),ke=kinetic_energy();
+        ostringstream line;
+        line.precision(17);
+        line<<step_<<","<<time()<<","<<pe<<","<<ke<<","<<pe+ke<<","
+            <<temperature();
+        *energies<<line.str()<<"\n";
+    }
+    if(traj)write_binary_frame(*traj,carts());
+}
+
+void MolecularDynamics::run(size_t nsteps,ostream* energies,ostream* traj){
+    FMANII_TIMER(timer);
+    if(step_==0){
+        if(energies)*energies<<"step,time,potential,kinetic,total,temperature\n";
+        if(traj)write_binary_header(*traj,plan_.natoms());
+        if(opts_.output_every)output(energies,traj);
+    }
+    const double dt=opts_.timestep;
+    const bool langevin=opts_.thermostat==Thermostat::LANGEVIN;
+    const double c1=std::exp(-opts_.friction*dt),
+                 c2=std::sqrt(1.0-c1*c1);
+    Vector old;
+    auto kick=[&](){
+        for(size_t i=0;i<v_.size();++i)v_[i]-=0.5*dt*grad_[i]/masses_[i];
+        cons_.rattle(carts_,v_);
+    };
+    auto drift=[&](){
+        if(!cons_.empty())old=carts_;
+        for(size_t i=0;i<v_.size();++i)carts_[i]+=0.5*dt*v_[i];
+        if(!cons_.empty())cons_.shake(old,carts_,&v_,0.5*dt);
+    };
+    for(size_t s=0;s<nsteps;++s){
+        //Velocity Verlet, split around the Langevin step as BAOAB
+        kick();
+        drift();
+        if(langevin)
+            for(size_t i=0;i<v_.size();++i)
+                v_[i]=c1*v_[i]+c2*std::sqrt(kB_au*opts_.temperature/
+                                            masses_[i])*gauss_(rng_);
+        if(langevin)cons_.rattle(carts_,v_);
+        drift();
+        forces();
+        kick();
+        if(opts_.thermostat==Thermostat::BERENDSEN){
+            const double T=temperature();
+            if(T>0.0){
+                const double lambda=std::sqrt(1.0+dt/opts_.coupling*
+                                              (opts_.temperature/T-1.0));
+                for(double& vi:v_)vi*=lambda;
+            }
+        }
+        ++step_;
+        if(opts_.output_every && step_%opts_.output_every==0)
+            output(energies,traj);
+    }
+    FMANII_TRACE(timer,"md","phase",nsteps);
+}
+
+} //End namespace FManII
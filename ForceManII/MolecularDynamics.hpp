@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+#include "ForceManII/Constraints.hpp"
+#include "ForceManII/EvaluationPlan.hpp"
+#include <iosfwd>
+#include <random>
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+
+///Boltzmann's constant in Hartree per Kelvin
+constexpr double kB_au=3.166811563e-6;
+
+///Femtoseconds to atomic units of time
+constexpr double fs2au=41.341373336;
+
+///How MolecularDynamics controls the temperature
+enum class Thermostat{
+    NONE,///<Constant energy
+    BERENDSEN,///<Velocities are rescaled toward the target each step
+    LANGEVIN///<Friction and random kicks (BAOAB splitting)
+};
+
+///Which bonds MolecularDynamics holds at their equilibrium length
+enum class Constraints{
+    NONE,///<All bonds vibrate
+    H_BONDS,///<Bonds to hydrogen
+    ALL_BONDS///<Every bond
+};
+
+///The settings of a MolecularDynamics run, all in atomic units
+struct MDOptions{
+    double timestep=fs2au;///<One femtosecond
+    Thermostat thermostat=Thermostat::NONE;///<How to control the temperature
+    double temperature=300.0;///<Target temperature, in Kelvin
+    double coupling=100.0*fs2au;///<Berendsen's relaxation time
+    double friction=1.0/(100.0*fs2au);///<Langevin's collision rate
+    ///PAIR terms only use pairs within this distance plus skin, 0 for all
+    ///pairs.  The PAIR models must vanish past the cutoff, i.e. be Tabulated
+    ///with an rmax no larger than it (see tabulate_nonbonded()).
+    double cutoff=0.0;
+    ///Bonds held at the force field's r0 with SHAKE/RATTLE.  Fixing the bonds
+    ///to hydrogen allows time steps of about 2 fs instead of 0.5 fs.
+    Constraints constraints=Constraints::NONE;
+    double constraint_tol=1e-10;///<Relative error allowed in a bond length
+    double skin=2.0;///<The neighbor list is rebuilt after atoms move half this
+    size_t output_every=0;///<Steps between outputs, 0 for none
+    unsigned seed=5489;///<For Langevin kicks and initial velocities
+};
+
+/** \brief Velocity-Verlet molecular dynamics on the system of a plan
+ *
+ *  The topology and parameters come from the plan, each step only updates
+ *  the internal coordinates and adds up the gradient (see add_gradient()).
+ *  Atoms are kept in the plan's internal order, so a plan made with a
+ *  space-filling curve order helps here too; everything passed in or
+ *  returned uses the caller's numbering.
+ *
+ *  With a cutoff, the PAIR terms use a Verlet neighbor list: the pairs within
+ *  cutoff plus skin, picked from the plan's pairs (and their parameters) and
+ *  rebuilt once any atom has moved more than half the skin.
+ *
+ *  With constraints the starting geometry is moved onto them, positions are
+ *  corrected with SHAKE after each drift and velocities with RATTLE after
+ *  each kick, and the temperature counts 3N minus the number of constraints
+ *  degrees of freedom.
+ */
+class MolecularDynamics{
+public:
+    /** \brief Starts at \p carts with no velocity
+     *
+     *  \param[in] plan The system, it must outlive this object
+     *  \param[in] masses The mass of each atom, in a.u. (see atom_masses())
+     *  \throws std::runtime_error if there's a cutoff and a PAIR model that
+     *          isn't zero past it
+     */
+    MolecularDynamics(const EvaluationPlan& plan,
+                      const Vector& carts,
+                      const Vector& masses,
+                      const MDOptions& options=MDOptions());
+
+    ///Draws velocities from the Maxwell-Boltzmann distribution at \p T (K),
+    ///without net momentum and scaled to exactly \p T
+    void set_temperature(double T);
+
+    ///Sets the velocity of each atom (a.u.)
+    void set_velocities(const Vector& v);
+
+    /** \brief Takes \p nsteps steps
+     *
+     *  Every MDOptions::output_every steps (and before the first step of the
+     *  run), "step,time,potential,kinetic,total,temperature" is written to
+     *  \p energies as CSV and the geometry to \p traj as a binary trajectory
+     *  (see TrajectoryReader).  The CSV header and trajectory header are
+     *  written before step 0.
+     */
+    void run(size_t nsteps,std::ostream* energies=nullptr,
+             std::ostream* traj=nullptr);
+
+    size_t step()const{return step_;}///<Steps taken so far
+    double time()const{return step_*opts_.timestep;}///<In a.u.
+    Vector carts()const{return plan_.from_internal(carts_);}///<Positions
+    Vector velocities()const{return plan_.from_internal(v_);}///<Velocities
+    double potential_energy()const;///<Current potential energy
+    const EnergyType& energies()const{return egys_;}///<...of each term
+    double kinetic_energy()const;///<Current kinetic energy
+    double temperature()const;///<Current temperature, in Kelvin
+    size_t nlist_builds()const{return nbuilds_;}///<Neighbor list builds
+    size_t nconstraints()const{return cons_.size();}///<Constrained bonds
+
+private:
+    const EvaluationPlan& plan_;
+    MDOptions opts_;
+    Vector masses_,carts_,v_,grad_;///<All in the plan's internal order
+    Molecule mol_;///<The plan's coordinates, with the neighbor list for PAIR
+    ParamSet ps_;///<The plan's parameters, matching mol_
+    EnergyType egys_;
+    BondConstraints cons_;///<In the plan's internal order
+    std::mt19937_64 rng_;
+    std::normal_distribution<double> gauss_;///<Kept so runs can be split up
+    size_t step_=0,nbuilds_=0;
+    Vector list_carts_;///<Where the atoms were when the list was built
+
+    void build_list();
+    void forces();
+    void output(std::ostream* energies,std::ostream* traj)const;
+};
+
+} //End namespace FManII
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "ForceManII/Nonbonded.hpp"
+#include "ForceManII/Common.hpp"
+#include "ForceManII/Util.hpp"
+#include "ForceManII/Parallel.hpp"
+#include "ForceManII/ModelPotentials/LennardJones.hpp"
+#include "ForceManII/ModelPotentials/Electrostatics.hpp"
+
+using namespace std;
+namespace FManII {
+
+//The scale factor of a term, 1.0 if the term is not scaled
+inline double scale_factor(const ForceField& ff,const FFTerm_t& term){
+    return ff.scale_factors.count(term)?ff.scale_factors.at(term):1.0;
+}
+
+//The A and B coefficients of each pair, interleaved.  Parameters that were not
+//assigned from a class-pair table are converted from sigma and epsilon
+inline Vector lj_coefs(const map<string,Vector>& ps,size_t n){
+    Vector AB(2*n);
+    if(ps.count(Param_t::A)){
+        const Vector &As=ps.at(Param_t::A),&Bs=ps.at(Param_t::B);
+        DEBUG_CHECK(As.size()==n && Bs.size()==n,"len(pairs) != len(A,B)");
+        for(size_t k=0;k<n;++k){
+            AB[2*k]=As[k];
+            AB[2*k+1]=Bs[k];
+        }
+        return AB;
+    }
+    const Vector &ss=ps.at(Param_t::sigma),&es=ps.at(Param_t::epsilon);
+    DEBUG_CHECK(ss.size()==n && es.size()==n,"len(pairs) != len(LJ params)");
+    for(size_t k=0;k<n;++k){
+        const double s2=ss[k]*ss[k],s6=s2*s2*s2;
+        AB[2*k]=es[k]*s6*s6;
+        AB[2*k+1]=2.0*es[k]*s6;
+    }
+    return AB;
+}
+
+bool can_fuse(const ForceField& ff,const ParamSet& ps,
+              const string& pair_type){
+    const FFTerm_t lj_term(Model_t::LENNARD_JONES,pair_type),
+                   cl_term(Model_t::ELECTROSTATICS,pair_type);
+    if(!ps.count(lj_term)||!ps.count(cl_term))return false;
+    return dynamic_cast<const LennardJones*>(&ff.terms.at(lj_term).model()) &&
+           dynamic_cast<const Electrostatics*>(&ff.terms.at(cl_term).model());
+}
+
+//What one pass over the pairs needs
+struct PairData{
+    const Index_t* atoms;
+    const double* AB;
+    const double* qs;
+    const double* carts;
+    const Cell* cell;
+    double lj_scale,cl_scale;
+};
+
+//Adds the gradients (if Grad) and energies (if Egy) of pairs [begin,end) to
+//lj and cl (which may be the same buffer) and elj and ecl
+template<bool Grad,bool Egy>
+void pair_loop(const PairData& p,size_t begin,size_t end,
+               double* lj,double* cl,double& elj,double& ecl)
+{
+    for(size_t k=begin;k<end;++k){
+        const size_t i=p.atoms[2*k],j=p.atoms[2*k+1];
+        array<double,3> dr=diff(&p.carts[3*i],&p.carts[3*j]);
+        if(p.cell)dr=p.cell->minimum_image(dr);
+        const double inv2=1.0/dot(dr,dr),inv6=inv2*inv2*inv2;
+        const double A=p.AB[2*k],B=p.AB[2*k+1];
+        const double e_cl=p.cl_scale*p.qs[k]*std::sqrt(inv2);
+        if(Egy){
+            elj+=p.lj_scale*(A*inv6-B)*inv6;
+            ecl+=e_cl;
+        }
+        if(!Grad)continue;
+        //dE/dr over r, multiplying by dr then gives the gradient
+        const double f_lj=p.lj_scale*(6.0*B-12.0*A*inv6)*inv6*inv2,
+                     f_cl=-e_cl*inv2;
+        for(size_t x=0;x<3;++x){
+            lj[3*i+x]+=f_lj*dr[x];
+            lj[3*j+x]-=f_lj*dr[x];
+            cl[3*i+x]+=f_cl*dr[x];
+            cl[3*j+x]-=f_cl*dr[x];
+        }
+    }
+}
+
+void nonbonded_add(const ForceField& ff,
+                   const ParamSet& ps,
+                   const Molecule& coords,
+                   const string& pair_type,
+                   double* lj_grad,
+                   double* cl_grad,
+                   double* lj_egy,
+                   double* cl_egy,
+                   const Vector* geom)
+{
+    CHECK(!lj_grad==!cl_grad,"Need both gradients or neither");
+    CHECK(!lj_egy==!cl_egy,"Need both energies or neither");
+    const FFTerm_t lj_term(Model_t::LENNARD_JONES,pair_type),
+                   cl_term(Model_t::ELECTROSTATICS,pair_type);
+    const AtomTuples& pairs=coords.atom_numbers.at(pair_type);
+    const size_t n=pairs.size();
+    const Vector AB=lj_coefs(ps.at(lj_term),n);
+    const Vector &qs=ps.at(cl_term).at(Param_t::q);
+    const Vector& carts=geom?*geom:*coords.carts;
+    DEBUG_CHECK(qs.size()==n,"len(pairs) != len(charges)");
+    const PairData p{pairs.data().data(),AB.data(),qs.data(),carts.data(),
+                     coords.cell.get(),scale_factor(ff,lj_term),
+                     scale_factor(ff,cl_term)};
+    const bool grad=lj_grad,egy=lj_egy,shared=lj_grad==cl_grad;
+
+    //The first chunk of pairs adds straight into the output, the others into
+    //their own buffers, which are added in chunk order afterwards
+    const size_t nthreads=std::max<size_t>(get_num_threads(),1),
+                 nbuf=grad?carts.size():0;
+    vector<Vector> ljs(nthreads),cls(nthreads);
+    Vector eljs(nthreads,0.0),ecls(nthreads,0.0);
+    const size_t nchunks=parallel_for(n,nthreads,[&](size_t chunk,size_t begin,
+                                                     size_t end){
+        double *lj=lj_grad,*cl=cl_grad;
+        if(chunk && grad){
+            ljs[chunk].assign(nbuf,0.0);
+            lj=ljs[chunk].data();
+            cl=lj;
+            if(!shared){
+                cls[chunk].assign(nbuf,0.0);
+                cl=cls[chunk].data();
+            }
+        }
+        double &elj=eljs[chunk],&ecl=ecls[chunk];
+        if(grad && egy)pair_loop<true,true>(p,begin,end,lj,cl,elj,ecl);
+        else if(grad)pair_loop<true,false>(p,begin,end,lj,cl,elj,ecl);
+        else pair_loop<false,true>(p,begin,end,lj,cl,elj,ecl);
+    });
+    for(size_t chunk=1;chunk<nchunks && grad;++chunk)
+        for(size_t x=0;x<nbuf;++x){
+            lj_grad[x]+=ljs[chunk][x];
+            if(!shared)cl_grad[x]+=cls[chunk][x];
+        }
+    if(!egy)return;
+    *lj_egy=*cl_egy=0.0;
+    for(size_t chunk=0;chunk<nchunks;++chunk){
+        *lj_egy+=eljs[chunk];
+        *cl_egy+=ecls[chunk];
+    }
+}
+
+void nonbonded_deriv(size_t order,
+                     const ForceField& ff,
+                     const ParamSet& ps,
+                     const Molecule& coords,
+                     const string& pair_type,
+                     DerivType& rv)
+{
+    CHECK(order<2,"Fused nonbonded derivatives only go up to order 1");
+    const FFTerm_t lj_term(Model_t::LENNARD_JONES,pair_type),
+                   cl_term(Model_t::ELECTROSTATICS,pair_type);
+    Vector lj(order==0?1:coords.carts->size(),0.0),cl(lj.size(),0.0);
+    if(order==0)
+        nonbonded_add(ff,ps,coords,pair_type,nullptr,nullptr,&lj[0],&cl[0]);
+    else
+        nonbonded_add(ff,ps,coords,pair_type,lj.data(),cl.data(),nullptr,
+                      nullptr);
+    rv[lj_term]=move(lj);
+    rv[cl_term]=move(cl);
+}
+
+} //End namespace FManII
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+
+#include "ForceManII/FManIIDefs.hpp"
+#include "ForceManII/ForceField.hpp"
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+
+/** \brief True if the Lennard-Jones and electrostatic terms over pairs of
+ *         type \p pair_type can be evaluated by nonbonded_deriv
+ *
+ *  This requires both terms to have parameters in \p ps and to use the stock
+ *  LennardJones and Electrostatics models.
+ */
+bool can_fuse(const ForceField& ff,const ParamSet& ps,
+              const std::string& pair_type);
+
+/** \brief Adds the Lennard-Jones and electrostatic gradients and/or energies
+ *         of one type of pair to caller-owned buffers in a single pass
+ *
+ *  The gradients are added to what is already in the buffers, which may be
+ *  the same buffer to sum the two terms.  Scale factors are applied.
+ *
+ *  \param[in,out] lj_grad,cl_grad 3 elements per atom, or both null to skip
+ *                  the gradients
+ *  \param[out] lj_egy,cl_egy Set to the energies, or both null to skip them
+ *  \param[in] geom If not null, the geometry to use instead of
+ *                  \p coords.carts
+ */
+void nonbonded_add(const ForceField& ff,
+                   const ParamSet& ps,
+                   const Molecule& coords,
+                   const std::string& pair_type,
+                   double* lj_grad,
+                   double* cl_grad,
+                   double* lj_egy,
+                   double* cl_egy,
+                   const Vector* geom=nullptr);
+
+/** \brief Computes the Lennard-Jones and electrostatic terms of one type of
+ *         pair in a single pass over the pairs
+ *
+ *  Each pair's distance is computed once from the Cartesian coordinates and
+ *  used for both terms; the force field's scale factors are applied as the
+ *  terms are accumulated.  The results are placed in \p rv under the same
+ *  keys deriv() would use, so callers still see the per-term derivatives.
+ *
+ *  \param[in] order The derivative order, only 0 and 1 are supported
+ *  \param[in] ff The force field that \p ps came from
+ *  \param[in] ps The parameters for the system
+ *  \param[in] coords The system
+ *  \param[in] pair_type Which pairs to evaluate (e.g. IntCoord_t::PAIR14)
+ *  \param[out] rv Where the two derivatives are put
+ */
+void nonbonded_deriv(size_t order,
+                     const ForceField& ff,
+                     const ParamSet& ps,
+                     const Molecule& coords,
+                     const std::string& pair_type,
+                     DerivType& rv);
+
+} //End namespace FManII
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "ForceManII/Parallel.hpp"
+#include "ForceManII/Profile.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+namespace FManII {
+
+static atomic<size_t> num_threads_(1);
+static thread_local bool serial_=false;
+
+void set_num_threads(size_t nthreads){
+    if(!nthreads)nthreads=max<size_t>(thread::hardware_concurrency(),1);
+    num_threads_=nthreads;
+}
+
+size_t get_num_threads(){return serial_?1:num_threads_.load();}
+
+SerialRegion::SerialRegion():was_serial_(serial_){serial_=true;}
+
+SerialRegion::~SerialRegion(){serial_=was_serial_;}
+
+size_t parallel_for(size_t n,size_t max_chunks,
+                    const function<void(size_t,size_t,size_t)>& fxn){
+    const size_t nchunks=serial_?min<size_t>(1,n):min(max_chunks,n);
+    if(nchunks<=1){
+        if(n)fxn(0,0,n);
+        return n?1:0;
+    }
+    vector<exception_ptr> errors(nchunks);
+    auto run=[&](size_t chunk){
+        const size_t begin=chunk*n/nchunks,end=(chunk+1)*n/nchunks;
+        FMANII_TIMER(timer);
+        try{fxn(chunk,begin,end);}
+        catch(...){errors[chunk]=current_exception();}
+        FMANII_TRACE(timer,"chunk "+to_string(chunk),"parallel",end-begin);
+    };
+    vector<thread> threads;
+    for(size_t chunk=1;chunk<nchunks;++chunk)threads.emplace_back(run,chunk);
+    run(0);
+    for(thread& t:threads)t.join();
+    for(const exception_ptr& e:errors)
+        if(e)rethrow_exception(e);
+    return nchunks;
+}
+
+} //End namespace FManII
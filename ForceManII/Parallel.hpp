@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+
+/** \brief Sets how many threads ForceManII may use
+ *
+ *  The default is 1.  Passing 0 uses one thread per hardware thread.
+ */
+void set_num_threads(size_t nthreads);
+
+///Returns how many threads ForceManII may use, 1 inside a SerialRegion
+size_t get_num_threads();
+
+/** \brief While it exists, everything the thread that made it runs is serial
+ *
+ *  For callers that already split their work among the threads (e.g. one
+ *  geometry per thread), so the work within each piece doesn't start threads
+ *  of its own.  Other threads are unaffected.
+ */
+class SerialRegion{
+    bool was_serial_;
+public:
+    SerialRegion();
+    ~SerialRegion();
+    SerialRegion(const SerialRegion&)=delete;
+    SerialRegion& operator=(const SerialRegion&)=delete;
+};
+
+/** \brief Splits [0,n) into contiguous chunks and calls \p fxn on each chunk
+ *         from its own thread
+ *
+ *  The chunks are ordered, chunk 0 covers the start of the range and is run
+ *  on the calling thread.  Inside a SerialRegion there is only one chunk.
+ *  If any call throws, the first exception (by chunk) is rethrown once all
+ *  threads have finished.
+ *
+ *  \param[in] n The number of items
+ *  \param[in] max_chunks The most chunks to make, fewer are made if n is
+ *                        smaller
+ *  \param[in] fxn Called as fxn(chunk,begin,end) for each chunk
+ *  \return The number of chunks used
+ */
+size_t parallel_for(size_t n,size_t max_chunks,
+                    const std::function<void(size_t,size_t,size_t)>& fxn);
+
+///parallel_for with one chunk per thread ForceManII may use
+inline size_t parallel_for(size_t n,
+                    const std::function<void(size_t,size_t,size_t)>& fxn){
+    return parallel_for(n,get_num_threads(),fxn);
+}
+
+} //End namespace FManII
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "ForceManII/Profile.hpp"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+namespace FManII {
+
+static Profile profile_;
+static mutex profile_mutex_;
+
+static atomic<bool> tracing_(false);
+static chrono::steady_clock::time_point trace_start_;
+static vector<TraceEvent> trace_;
+static map<thread::id,size_t> thread_numbers_;
+static mutex trace_mutex_;
+
+inline void add(ProfileEntry& entry,double seconds,size_t ncoords,
+                size_t bytes){
+    ++entry.calls;
+    entry.seconds+=seconds;
+    entry.ncoords+=ncoords;
+    entry.bytes+=bytes;
+}
+
+bool profiling_enabled(){
+#ifdef FMANII_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+Profile get_profile(){
+    lock_guard<mutex> lock(profile_mutex_);
+    return profile_;
+}
+
+void reset_profile(){
+    lock_guard<mutex> lock(profile_mutex_);
+    profile_=Profile();
+}
+
+void start_trace(){
+    lock_guard<mutex> lock(trace_mutex_);
+    trace_.clear();
+    thread_numbers_.clear();
+    trace_start_=chrono::steady_clock::now();
+    tracing_=true;
+}
+
+void stop_trace(){tracing_=false;}
+
+vector<TraceEvent> get_trace(){
+    lock_guard<mutex> lock(trace_mutex_);
+    return trace_;
+}
+
+void write_trace(ostream& os){
+    const vector<TraceEvent> events=get_trace();
+    os<<"{\"traceEvents\": ["<<endl;
+    for(size_t i=0;i<events.size();++i){
+        const TraceEvent& e=events[i];
+        os<<"  {\"name\": \""<<e.name<<"\", \"cat\": \""<<e.category
+          <<"\", \"ph\": \"X\", \"ts\": "<<e.start_us
+          <<", \"dur\": "<<e.duration_us<<", \"pid\": 1, \"tid\": "<<e.thread
+          <<", \"args\": {\"count\": "<<e.count<<"}}"
+          <<(i+1<events.size()?",":"")<<endl;
+    }
+    os<<"], \"displayTimeUnit\": \"ms\"}"<<endl;
+}
+
+namespace detail {
+
+void record_event(const ProfileTimer& timer,const string& name,
+                  const string& category,size_t count){
+    if(!tracing_)return;
+    const auto now=chrono::steady_clock::now();
+    lock_guard<mutex> lock(trace_mutex_);
+    const auto id=this_thread::get_id();
+    if(!thread_numbers_.count(id))
+        thread_numbers_.emplace(id,thread_numbers_.size());
+    TraceEvent e;
+    e.name=name;
+    e.category=category;
+    e.start_us=chrono::duration<double,micro>(timer.start()-trace_start_).count();
+    e.duration_us=chrono::duration<double,micro>(now-timer.start()).count();
+    e.thread=thread_numbers_.at(id);
+    e.count=count;
+    trace_.push_back(e);
+}
+
+void record_phase(const string& phase,double seconds,size_t ncoords,
+                  size_t bytes){
+    lock_guard<mutex> lock(profile_mutex_);
+    add(profile_.phases[phase].total,seconds,ncoords,bytes);
+}
+
+void record_term(const string& phase,const FFTerm_t& term,double seconds,
+                 size_t ncoords,size_t bytes){
+    lock_guard<mutex> lock(profile_mutex_);
+    add(profile_.phases[phase].terms[term],seconds,ncoords,bytes);
+}
+
+}//End namespace detail
+} //End namespace FManII
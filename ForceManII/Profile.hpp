@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+
+#include "ForceManII/FManIIDefs.hpp"
+#include <chrono>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+
+///What was recorded for one phase or one term
+struct ProfileEntry{
+    size_t calls=0;///<How many times it ran
+    double seconds=0.0;///<Total wall time
+    size_t ncoords=0;///<Total number of internal coordinates handled
+    size_t bytes=0;///<Total bytes allocated for the results
+};
+
+///What was recorded for one phase of a computation
+struct PhaseProfile{
+    ProfileEntry total;///<The phase as a whole
+    std::map<FFTerm_t,ProfileEntry> terms;///<Each term within the phase
+};
+
+/** \brief Everything recorded since the last reset_profile()
+ *
+ *  The phases are "get_coords", "assign_params" and "deriv".  Only the last two
+ *  are broken down by term.  Terms that are evaluated together (the fused
+ *  Lennard-Jones and electrostatics) split their time equally.
+ */
+struct Profile{
+    std::map<std::string,PhaseProfile> phases;///<Keyed by phase name
+};
+
+/** \brief True if ForceManII was built with ENABLE_PROFILING
+ *
+ *  Without it nothing is recorded and get_profile() is always empty.
+ */
+bool profiling_enabled();
+
+///Returns everything recorded since the last reset (thread-safe)
+Profile get_profile();
+
+///Forgets everything recorded so far (thread-safe)
+void reset_profile();
+
+///One span of time in a trace
+struct TraceEvent{
+    std::string name;///<What ran, e.g. "get_coords" or a term's name
+    std::string category;///<"phase", "assign_params", "deriv" or "parallel"
+    double start_us=0.0;///<When it started, in microseconds since start_trace()
+    double duration_us=0.0;///<How long it ran, in microseconds
+    size_t thread=0;///<Which thread ran it, numbered as they are first seen
+    size_t count=0;///<Coordinates (or items for "parallel") handled
+};
+
+/** \brief Starts recording a trace, discarding any previous one
+ *
+ *  Each phase, the parameters of each term, the derivative of each term and,
+ *  when more than one thread is used, each thread's chunk of work become an
+ *  event.  Like the profile this needs ENABLE_PROFILING, otherwise no events
+ *  are ever recorded.
+ */
+void start_trace();
+
+///Stops recording the trace, events recorded so far are kept
+void stop_trace();
+
+///Returns the events recorded so far (thread-safe)
+std::vector<TraceEvent> get_trace();
+
+/** \brief Writes the recorded events in the Chrome trace event format
+ *
+ *  The result can be loaded into chrome://tracing or ui.perfetto.dev.
+ */
+void write_trace(std::ostream& os);
+
+namespace detail {
+
+///Measures the wall time since it was made
+class ProfileTimer{
+    std::chrono::steady_clock::time_point start_;
+public:
+    ProfileTimer():start_(std::chrono::steady_clock::now()){}
+    std::chrono::steady_clock::time_point start()const{return start_;}
+    double seconds()const{
+        const std::chrono::duration<double> dt=
+                std::chrono::steady_clock::now()-start_;
+        return dt.count();
+    }
+};
+
+///Adds one call of a phase to the profile
+void record_phase(const std::string& phase,double seconds,size_t ncoords,
+                  size_t bytes);
+
+///Adds one call of a term within a phase to the profile
+void record_term(const std::string& phase,const FFTerm_t& term,double seconds,
+                 size_t ncoords,size_t bytes);
+
+///Adds an event lasting from \p timer's creation until now, if tracing
+void record_event(const ProfileTimer& timer,const std::string& name,
+                  const std::string& category,size_t count);
+
+///The bytes held by a vector's buffer
+template<typename T>
+size_t bytes_of(const std::vector<T>& v){return v.capacity()*sizeof(T);}
+
+}//End namespace detail
+
+//The library records through these so it costs nothing when disabled, their
+//arguments are not even evaluated
+#ifdef FMANII_PROFILE
+#define FMANII_TIMER(name) FManII::detail::ProfileTimer name
+#define FMANII_RECORD_PHASE(phase,seconds,ncoords,bytes)\
+    FManII::detail::record_phase(phase,seconds,ncoords,bytes)
+#define FMANII_RECORD_TERM(phase,term,seconds,ncoords,bytes)\
+    FManII::detail::record_term(phase,term,seconds,ncoords,bytes)
+#define FMANII_TRACE(timer,name,category,count)\
+    FManII::detail::record_event(timer,name,category,count)
+#else
+#define FMANII_TIMER(name)
+#define FMANII_RECORD_PHASE(phase,seconds,ncoords,bytes)
+#define FMANII_RECORD_TERM(phase,term,seconds,ncoords,bytes)
+#define FMANII_TRACE(timer,name,category,count)
+#endif
+
+} //End namespace FManII
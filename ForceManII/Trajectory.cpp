@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "ForceManII/Trajectory.hpp"
+#include "ForceManII/Common.hpp"
+#include "ForceManII/Profile.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+namespace FManII {
+
+static const char traj_magic[]="FMIITRJ1";
+static const char egy_magic[]="FMIIEGY1";
+//Batches read ahead of the one being evaluated
+constexpr size_t max_queued=2;
+
+//Splits a line on whitespace
+inline vector<string> split(const string& line){
+    istringstream iss(line);
+    vector<string> rv;
+    string token;
+    while(iss>>token)rv.push_back(token);
+    return rv;
+}
+
+inline bool is_number(const string& token){
+    char* end;
+    strtod(token.c_str(),&end);
+    return end!=token.c_str() && *end=='\0';
+}
+
+template<typename T>
+void write_raw(ostream& os,const T& value){
+    os.write(reinterpret_cast<const char*>(&value),sizeof(T));
+}
+
+TrajectoryReader::TrajectoryReader(istream& is,TrajFormat format,
+                                   double ang2au):
+    is_(is),format_(format),ang2au_(ang2au)
+{
+    if(format_==TrajFormat::BINARY){
+        char magic[8];
+        uint64_t natoms=0;
+        is_.read(magic,8);
+        is_.read(reinterpret_cast<char*>(&natoms),sizeof(natoms));
+        CHECK(is_ && !memcmp(magic,traj_magic,8),
+              "Not a binary ForceManII trajectory");
+        natoms_=natoms;
+        return;
+    }
+    have_first_=next_tinker(first_,true);
+    CHECK(have_first_,"Trajectory has no frames");
+}
+
+bool TrajectoryReader::next_tinker(Vector& carts,bool first){
+    string line;
+    vector<string> tokens;
+    //Frames may be separated by blank lines
+    while(tokens.empty()){
+        if(!getline(is_,line))return false;
+        tokens=split(line);
+    }
+    const string frame=to_string(nframes_);
+    CHECK(is_number(tokens[0]),"Frame "+frame+" doesn't start with the "
+                                  "number of atoms");
+    const size_t n=stoul(tokens[0]);
+    CHECK(first || n==natoms_,"Frame "+frame+" has "+to_string(n)+
+          " atoms, not "+to_string(natoms_));
+    natoms_=n;
+    Vector rv(3*n);
+    for(size_t i=0;i<n;){
+        CHECK(static_cast<bool>(getline(is_,line)),
+              "Trajectory ends in the middle of frame "+frame);
+        tokens=split(line);
+        //Periodic frames start with a box line, a b c alpha beta gamma
+        if(i==0 && tokens.size()==6 && is_number(tokens[1]))continue;
+        CHECK(tokens.size()>=6,"Atom lines need a number, symbol, x, y, z "
+                               "and type, see frame "+frame);
+        for(size_t x=0;x<3;++x)rv[3*i+x]=stod(tokens[2+x])*ang2au_;
+        if(first){
+            types_.push_back(stoul(tokens[5]));
+            set<size_t> bonded;
+            for(size_t j=6;j<tokens.size();++j)
+                bonded.insert(stoul(tokens[j])-1);//Tinker starts at 1
+            conns_.push_back(bonded);
+        }
+        ++i;
+    }
+    carts=move(rv);
+    return true;
+}
+
+bool TrajectoryReader::next(Vector& carts){
+    if(format_==TrajFormat::TINKER){
+        if(have_first_){
+            have_first_=false;
+            carts=move(first_);
+        }
+        else if(!next_tinker(carts,false))return false;
+        ++nframes_;
+        return true;
+    }
+    Vector rv(3*natoms_);
+    is_.read(reinterpret_cast<char*>(rv.data()),rv.size()*sizeof(double));
+    if(is_.gcount()==0)return false;
+    CHECK(static_cast<size_t>(is_.gcount())==rv.size()*sizeof(double),
+          "Trajectory ends in the middle of frame "+to_string(nframes_));
+    carts=move(rv);
+    ++nframes_;
+    return true;
+}
+
+void write_binary_header(ostream& os,size_t natoms){
+    os.write(traj_magic,8);
+    write_raw(os,static_cast<uint64_t>(natoms));
+}
+
+void write_binary_frame(ostream& os,const Vector& carts){
+    os.write(reinterpret_cast<const char*>(carts.data()),
+             carts.size()*sizeof(double));
+}
+
+size_t rescore(TrajectoryReader& reader,
+               const EvaluationPlan& plan,
+               ostream& os,
+               EnergyFormat format,
+               size_t frames_per_batch)
+{
+    FMANII_TIMER(timer);
+    CHECK(reader.natoms()==plan.natoms(),"Trajectory has "+
+          to_string(reader.natoms())+" atoms, the plan has "+
+          to_string(plan.natoms()));
+    CHECK(frames_per_batch>0,"Need at least one frame per batch");
+    vector<FFTerm_t> terms;
+    vector<string> columns({"frame","total"});
+    for(const auto& pi:plan.params()){
+        terms.push_back(pi.first);
+        columns.push_back(pi.first.first+" "+pi.first.second);
+    }
+    if(format==EnergyFormat::CSV)
+        for(size_t i=0;i<columns.size();++i)
+            os<<columns[i]<<(i+1<columns.size()?",":"\n");
+    else{
+        os.write(egy_magic,8);
+        write_raw(os,static_cast<uint64_t>(columns.size()));
+        for(const string& column:columns){
+            write_raw(os,static_cast<uint64_t>(column.size()));
+            os.write(column.data(),column.size());
+        }
+    }
+
+    //The reader thread fills the queue with batches of frames
+    mutex m;
+    condition_variable cv;
+    deque<Vector> queue;
+    bool done=false,stop=false;
+    exception_ptr error;
+    const size_t n=3*plan.natoms();
+    thread read([&](){
+        try{
+            Vector carts;
+            bool more=true;
+            while(more){
+                Vector frames;
+                frames.reserve(frames_per_batch*n);
+                while(frames.size()<frames_per_batch*n &&
+                      (more=reader.next(carts)))
+                    frames.insert(frames.end(),carts.begin(),carts.end());
+                unique_lock<mutex> lock(m);
+                cv.wait(lock,[&](){return stop || queue.size()<max_queued;});
+                if(stop)break;
+                if(!frames.empty())queue.push_back(move(frames));
+                cv.notify_all();
+            }
+        }
+        catch(...){
+            lock_guard<mutex> lock(m);
+            error=current_exception();
+        }
+        lock_guard<mutex> lock(m);
+        done=true;
+        cv.notify_all();
+    });
+
+    size_t nframes=0;
+    try{
+        vector<EnergyType> egys;
+        while(true){
+            Vector frames;
+            {
+                unique_lock<mutex> lock(m);
+                cv.wait(lock,[&](){return done || !queue.empty();});
+                if(queue.empty())break;
+                frames=move(queue.front());
+                queue.pop_front();
+                cv.notify_all();
+            }
+            const Vector totals=plan.batch(frames,nullptr,&egys);
+            for(size_t f=0;f<totals.size();++f,++nframes){
+                Vector row({static_cast<double>(nframes),totals[f]});
+                for(const FFTerm_t& term:terms)
+                    row.push_back(egys[f].count(term)?egys[f].at(term):0.0);
+                if(format==EnergyFormat::BINARY){
+                    os.write(reinterpret_cast<const char*>(row.data()),
+                             row.size()*sizeof(double));
+                    continue;
+                }
+                ostringstream line;
+                line.precision(17);
+                line<<nframes;
+                for(size_t i=1;i<row.size();++i)line<<","<<row[i];
+                os<<line.str()<<"\n";
+            }
+        }
+    }
+    catch(...){
+        {
+            lock_guard<mutex> lock(m);
+            stop=true;
+            cv.notify_all();
+        }
+        read.join();
+        throw;
+    }
+    read.join();
+    if(error)rethrow_exception(error);
+    CHECK(static_cast<bool>(os),"Failed to write the energies");
+    FMANII_TRACE(timer,"rescore","phase",nframes);
+    return nframes;
+}
+
+} //End namespace FManII
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+#include "ForceManII/EvaluationPlan.hpp"
+#include <iosfwd>
+#include <string>
+
+///Namespace for all code associated with ForceManII
+namespace FManII {
+
+///The file formats a trajectory may be in
+enum class TrajFormat{
+    TINKER,///<Tinker .xyz/.arc, the frames one after another, in Angstroms
+    BINARY ///<A header, then the Cartesian coordinates of each frame in a.u.
+};
+
+/** \brief Reads the frames of a trajectory one at a time
+ *
+ *  Only one frame is held in memory, so trajectories of any length can be
+ *  streamed.  In Tinker files the atom types and connectivity are taken from
+ *  the first frame and box lines are skipped (pass the cell to the
+ *  EvaluationPlan instead).
+ *
+ *  The binary format is 8 bytes "FMIITRJ1" and the number of atoms as a
+ *  uint64_t, followed by 3*natoms doubles per frame.  Use
+ *  write_binary_header() and write_binary_frame() to make one.  Both are in
+ *  the byte order of the machine.
+ */
+class TrajectoryReader{
+public:
+    /** \brief Starts reading the first frame of \p is
+     *
+     *  \param[in] is The stream, it must outlive the reader
+     *  \param[in] ang2au The conversion from Angstroms to Bohr
+     */
+    TrajectoryReader(std::istream& is,TrajFormat format,
+                     double ang2au=1.889725989);
+
+    ///The number of atoms in each frame
+    size_t natoms()const{return natoms_;}
+
+    ///The number of frames read so far
+    size_t nframes()const{return nframes_;}
+
+    ///Atom types from the first frame, empty for binary files
+    const IVector& types()const{return types_;}
+
+    ///Bonds from the first frame, empty for binary files
+    const ConnData& conns()const{return conns_;}
+
+    /** \brief Reads the next frame
+     *
+     *  \param[out] carts Set to the frame's Cartesian coordinates, in a.u.
+     *  \return False, and \p carts is untouched, if there are no more frames
+     */
+    bool next(Vector& carts);
+
+private:
+    std::istream& is_;
+    TrajFormat format_;
+    double ang2au_;
+    size_t natoms_=0,nframes_=0;
+    IVector types_;
+    ConnData conns_;
+    Vector first_;///<The first frame, read to learn natoms_
+    bool have_first_=false;
+
+    bool next_tinker(Vector& carts,bool first);
+};
+
+///Writes the header of a binary trajectory (see TrajectoryReader)
+void write_binary_header(std::ostream& os,size_t natoms);
+
+///Appends a frame (3 elements per atom, a.u.) to a binary trajectory
+void write_binary_frame(std::ostream& os,const Vector& carts);
+
+///The formats rescore() can write energies in
+enum class EnergyFormat{
+    CSV,///<A header line, then "frame,total,<one column per term>" per frame
+    BINARY///<"FMIIEGY1", the number of columns as a uint64_t, each column's
+          ///name as a uint64_t length then its characters, then one double
+          ///per column per frame.  The columns are as for CSV.
+};
+
+/** \brief Computes the energy of each term of every frame of a trajectory
+ *
+ *  One thread reads frames while the others evaluate the previous batch
+ *  (see EvaluationPlan::batch()), so the setup is done once and the reading
+ *  overlaps with the work.  The terms are named "<model> <coordinate>".
+ *
+ *  \param[in] reader Where the frames come from, its atoms must be the plan's
+ *  \param[in] plan The system the frames are geometries of
+ *  \param[out] os Where the energies are written
+ *  \param[in] frames_per_batch How many frames are evaluated at once
+ *  \return The number of frames rescored
+ */
+size_t rescore(TrajectoryReader& reader,
+               const EvaluationPlan& plan,
+               std::ostream& os,
+               EnergyFormat format=EnergyFormat::CSV,
+               size_t frames_per_batch=256);
+
+} //End namespace FManII
@@ -48,6 +48,50 @@ pair<Vector,ConnData> make_carts_conns(const Wavefunction& wfn)
     return {Carts,conns};
 }
 
+EvaluationPlan& PlanCache::plan(const string& ff_name,
+                                const IVector& types,
+                                const Vector& carts,
+                                const ConnData& conns,
+                                const TermFilter& filter,
+                                const string& filter_key)
+{
+    if(!plan_ || ff_name!=ff_name_ || types!=types_ || conns!=conns_ ||
+       filter_key!=filter_key_){
+        plan_.reset(new EvaluationPlan(carts,conns,get_ff(ff_name),types,
+                                       nullptr,AtomOrder::INPUT,true,filter));
+        ff_name_=ff_name;
+        filter_key_=filter_key;
+        types_=types;
+        conns_=conns;
+    }
+    return *plan_;
+}
+
+DerivType PlanCache::deriv(size_t order,
+                           const string& ff_name,
+                           const IVector& types,
+                           const Vector& carts,
+                           const ConnData& conns,
+                           const TermFilter& filter,
+                           const string& filter_key)
+{
+    lock_guard<mutex> lock(mutex_);
+    return plan(ff_name,types,carts,conns,filter,filter_key).deriv(order,carts);
+}
+
+Vector PlanCache::gradient(const string& ff_name,
+                           const IVector& types,
+                           const Vector& carts,
+                           const ConnData& conns,
+                           const TermFilter& filter,
+                           const string& filter_key)
+{
+    lock_guard<mutex> lock(mutex_);
+    Vector rv(carts.size(),0.0);
+    plan(ff_name,types,carts,conns,filter,filter_key).add_gradient(carts,rv);
+    return rv;
+}
+
 DerivReturnType FFPulsar::deriv_(size_t Order,const Wavefunction& wfn)
 {
     auto ff_name=options().get<string>("FORCE_FIELD");
@@ -60,11 +104,19 @@ DerivReturnType FFPulsar::deriv_(size_t Order,const Wavefunction& wfn)
     pair<Vector,ConnData> geom=make_carts_conns(wfn);
     const Vector& Carts=geom.first;
     const ConnData& conns=geom.second;
-    auto deriv_comps=run_forcemanii(Order,Carts,conns,get_ff(ff_name),types);
+    //Skipped terms are never set up or computed
+    string key;
+    for(const auto& skipped:{m2s,c2s}){
+        for(const string& name:skipped)key+=name+",";
+        key+=";";
+    }
+    if(Order==1)
+        return {wfn,plan_.gradient(ff_name,types,Carts,conns,
+                                   skip_terms(m2s,c2s),key)};
+    auto deriv_comps=plan_.deriv(Order,ff_name,types,Carts,conns,
+                                 skip_terms(m2s,c2s),key);
     Vector deriv(std::pow(Carts.size(),Order));
     for(const auto& dci:deriv_comps){
-        if(find(m2s.begin(),m2s.end(),dci.first.first)!=m2s.end() ||
-           find(c2s.begin(),c2s.end(),dci.first.second)!=c2s.end())continue;
         const auto& di=dci.second;
         for(size_t i=0;i<di.size();++i)
             deriv[i]+=di[i];
@@ -85,8 +137,12 @@ DerivReturnType FFTermPulsar::deriv_(size_t Order,const Wavefunction& wfn)
     pair<Vector,ConnData> geom=make_carts_conns(wfn);
     const Vector& Carts=geom.first;
     const ConnData& conns=geom.second;
-    auto deriv_comps=run_forcemanii(Order,Carts,conns,get_ff(ff_name),types);
-    if(model_name=="ALL" && intcoord_name=="ALL")
+    const bool all=model_name=="ALL" && intcoord_name=="ALL";
+    const FFTerm_t term(model_name,intcoord_name);
+    auto deriv_comps=plan_.deriv(Order,ff_name,types,Carts,conns,
+                                 all?TermFilter():only_term(term),
+                                 all?string("ALL"):model_name+" "+intcoord_name);
+    if(all)
     {
        Vector deriv(std::pow(Carts.size(),Order));
        for(const auto& dci:deriv_comps){
@@ -96,7 +152,9 @@ DerivReturnType FFTermPulsar::deriv_(size_t Order,const Wavefunction& wfn)
        }
        return {wfn,deriv};
     }
-    return {wfn,deriv_comps.at(make_pair(model_name,intcoord_name))};
+    CHECK(deriv_comps.count(term),"System has no "+model_name+" "+
+          intcoord_name+" term");
+    return {wfn,deriv_comps.at(term)};
 }
 
 Vector FFCharges::calculate_(unsigned int deriv,
@@ -21,20 +21,73 @@
 
 #include<pulsar/modulebase/EnergyMethod.hpp>
 #include<pulsar/modulebase/PropertyCalculator.hpp>
+#include<ForceManII/EvaluationPlan.hpp>
+#include<memory>
+#include<mutex>
 
 namespace FManII {
 
+/** \brief Keeps the EvaluationPlan of the last system a module was called on
+ *
+ *  In an optimization or QM/MM run the bonds and atom types don't change
+ *  between calls, so the internal coordinates and parameters are only found
+ *  again when the force field, atom types, connectivity, or terms requested
+ *  do.  Otherwise just the geometry is updated.
+ */
+class PlanCache{
+    std::string ff_name_,filter_key_;
+    IVector types_;
+    ConnData conns_;
+    std::unique_ptr<EvaluationPlan> plan_;
+    std::mutex mutex_;
+
+    ///The plan for the inputs, remade if they changed, assumes mutex_ is held
+    EvaluationPlan& plan(const std::string& ff_name,
+                         const IVector& types,
+                         const Vector& carts,
+                         const ConnData& conns,
+                         const TermFilter& filter,
+                         const std::string& filter_key);
+public:
+    /** \brief The derivatives of each term at \p carts, making a new plan if
+     *         needed
+     *
+     *  \param[in] filter Which terms to compute
+     *  \param[in] filter_key Identifies \p filter, filters are only compared
+     *                        by their keys
+     */
+    DerivType deriv(size_t order,
+                    const std::string& ff_name,
+                    const IVector& types,
+                    const Vector& carts,
+                    const ConnData& conns,
+                    const TermFilter& filter,
+                    const std::string& filter_key);
+
+    ///The gradient at \p carts summed over the terms, see deriv()
+    Vector gradient(const std::string& ff_name,
+                    const IVector& types,
+                    const Vector& carts,
+                    const ConnData& conns,
+                    const TermFilter& filter,
+                    const std::string& filter_key);
+};
+
 
 class FFPulsar:public pulsar::EnergyMethod{
 public:
     FFPulsar(ID_t id): EnergyMethod(id){}
     pulsar::DerivReturnType deriv_(size_t Order,const pulsar::Wavefunction& wfn);
+private:
+    PlanCache plan_;
 };
 
 class FFTermPulsar:public pulsar::EnergyMethod{
 public:
     FFTermPulsar(ID_t id): EnergyMethod(id){}
     pulsar::DerivReturnType deriv_(size_t Order,const pulsar::Wavefunction& wfn);
+private:
+    PlanCache plan_;
 };
 
 class FFCharges:public pulsar::PropertyCalculator{
@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+
+#pragma once
+#include <ForceManII/FManII.hpp>
+#include "PerfCounters.hpp"
+#include <sys/resource.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+///The timings of one phase of a computation on one system
+struct BenchResult{
+    std::string system;///<Name of the molecule
+    std::string force_field;///<Name of the force field
+    std::string phase;///<What was timed (e.g. "deriv1")
+    size_t natoms=0;///<Number of atoms in the system
+    size_t ncoords=0;///<Number of internal coordinates handled per repeat
+    size_t nthreads=1;///<Number of threads the phase was allowed to use
+    size_t repeats=0;///<How many times the phase was run
+    double min_time=0.0;///<Fastest wall time of a repeat, in seconds
+    double mean_time=0.0;///<Average wall time of a repeat, in seconds
+    long rss_kb=0;///<Resident memory of the process after the phase
+    long peak_rss_kb=0;///<Peak resident memory of the process after the phase
+    ///Hardware events per repeat (see PerfCounters), -1 if not counted
+    PerfCounts counters={{-1,-1,-1,-1}};
+};
+
+///The largest resident set size the process has had so far, in kB
+inline long peak_rss_kb(){
+    struct rusage usage;
+    getrusage(RUSAGE_SELF,&usage);
+    return usage.ru_maxrss;
+}
+
+///The current resident set size of the process in kB, 0 if unknown
+inline long rss_kb(){
+    std::ifstream statm("/proc/self/statm");
+    long pages=0,resident=0;
+    if(!(statm>>pages>>resident))return 0;
+    return resident*(sysconf(_SC_PAGESIZE)/1024);
+}
+
+///The total number of internal coordinates in a molecule
+inline size_t count_coords(const FManII::Molecule& mol){
+    size_t n=0;
+    for(const auto& ci:mol.atom_numbers)n+=ci.second.size();
+    return n;
+}
+
+/** \brief Times a phase by calling it \p repeats times
+ *
+ *  \param[in] fxn The phase, it's called with no arguments
+ *  \param[in,out] rv On input the names and sizes to report, on output also
+ *                    the timings
+ *  \param[in] counters If not null, the hardware events are also counted and
+ *                       averaged over the repeats
+ */
+template<typename Fxn>
+inline void time_phase(Fxn&& fxn,size_t repeats,BenchResult& rv,
+                       PerfCounters* counters=nullptr){
+    using clock=std::chrono::steady_clock;
+    rv.repeats=repeats;
+    rv.min_time=1e300;
+    double total=0.0;
+    PerfCounts events={{0,0,0,0}};
+    for(size_t i=0;i<repeats;++i){
+        if(counters)counters->start();
+        const auto start=clock::now();
+        fxn();
+        const std::chrono::duration<double> dt=clock::now()-start;
+        if(counters){
+            const PerfCounts c=counters->stop();
+            for(size_t j=0;j<nperf_events;++j)
+                events[j]=c[j]<0||events[j]<0?-1:events[j]+c[j];
+        }
+        rv.min_time=std::min(rv.min_time,dt.count());
+        total+=dt.count();
+    }
+    rv.mean_time=repeats?total/repeats:0.0;
+    if(counters && repeats)
+        for(size_t j=0;j<nperf_events;++j)
+            rv.counters[j]=events[j]<0?-1:events[j]/(long long)repeats;
+    rv.rss_kb=rss_kb();
+    rv.peak_rss_kb=peak_rss_kb();
+}
+
+/** \brief Times each kernel on its own: the values and derivatives of each
+ *         type of internal coordinate and the derivatives of each model
+ *
+ *  The internal coordinate kernels are reported as e.g. "intcoord ANGLE
+ *  deriv1" (the derivative of each angle with respect to its atoms) and the
+ *  models as e.g. "model HARMONICOSCILLATOR ANGLE deriv1" (the derivative of
+ *  the energy with respect to each angle).
+ */
+inline void bench_kernels(const BenchResult& base,
+                          const FManII::Molecule& mol,
+                          const FManII::ForceField& ff,
+                          const FManII::ParamSet& ps,
+                          size_t repeats,
+                          PerfCounters* counters,
+                          std::vector<BenchResult>& results){
+    for(const auto& ci:mol.atom_numbers){
+        const auto coord=FManII::get_intcoord(ci.first);
+        BenchResult r=base;
+        r.ncoords=ci.second.size();
+        for(size_t order=0;order<2;++order){
+            r.phase="intcoord "+ci.first+" deriv"+std::to_string(order);
+            FManII::Vector d;
+            time_phase([&](){
+                for(const FManII::AtomTuple atoms:ci.second)
+                    d=coord->deriv(order,*mol.carts,atoms,mol.cell.get());
+            },repeats,r,counters);
+            results.push_back(r);
+        }
+    }
+    for(const auto& pi:ps){
+        const FManII::ModelPotential& model=ff.terms.at(pi.first).model();
+        const std::vector<FManII::Vector> qs(1,mol.coords.at(pi.first.second));
+        BenchResult r=base;
+        r.ncoords=qs[0].size();
+        for(size_t order=0;order<2;++order){
+            r.phase="model "+pi.first.first+" "+pi.first.second+" deriv"+
+                    std::to_string(order);
+            FManII::Vector d;
+            time_phase([&](){d=model.deriv(order,pi.second,qs);},repeats,r,
+                       counters);
+            results.push_back(r);
+        }
+    }
+}
+
+/** \brief Times get_coords, assign_params, and deriv (orders 0 and 1) for
+ *         one system
+ *
+ *  \param[in] base The names and sizes to report for each phase
+ *  \param[in] repeats How many times to run each phase
+ *  \param[out] results Where the timings of each phase are added
+ *  \param[in] counters If not null, hardware events are counted for each
+ *                       phase and each kernel is also timed (see
+ *                       bench_kernels)
+ */
+inline void bench_phases(const BenchResult& base,
+                         const FManII::Vector& carts,
+                         const FManII::ConnData& conns,
+                         const FManII::ForceField& ff,
+                         const FManII::IVector& types,
+                         size_t repeats,
+                         std::vector<BenchResult>& results,
+                         PerfCounters* counters=nullptr){
+    FManII::Molecule mol;
+    BenchResult r=base;
+    r.phase="get_coords";
+    time_phase([&](){mol=FManII::get_coords(carts,conns);},repeats,r,counters);
+    r.ncoords=count_coords(mol);
+    results.push_back(r);
+
+    FManII::ParamSet ps;
+    const size_t ncoords=r.ncoords;
+    r=base;
+    r.ncoords=ncoords;
+    r.phase="assign_params";
+    time_phase([&](){ps=FManII::assign_params(mol,ff,types);},repeats,r,
+               counters);
+    results.push_back(r);
+
+    for(size_t order=0;order<2;++order){
+        FManII::DerivType d;
+        r.phase="deriv"+std::to_string(order);
+        time_phase([&](){d=FManII::deriv(order,ff,ps,mol);},repeats,r,counters);
+        results.push_back(r);
+    }
+    if(counters)bench_kernels(base,mol,ff,ps,repeats,counters,results);
+}
+
+/** \brief Times making an EvaluationPlan and the gradient through it
+ *
+ *  The phases are reported as "plan <order>" and "plan <order> deriv1",
+ *  where order is how the plan numbers the atoms internally.
+ */
+inline void bench_plan(const BenchResult& base,
+                       const FManII::Vector& carts,
+                       const FManII::ConnData& conns,
+                       const FManII::ForceField& ff,
+                       const FManII::IVector& types,
+                       FManII::AtomOrder order,
+                       const std::string& order_name,
+                       size_t repeats,
+                       std::vector<BenchResult>& results){
+    std::unique_ptr<FManII::EvaluationPlan> plan;
+    BenchResult r=base;
+    r.phase="plan "+order_name;
+    time_phase([&](){
+        plan.reset(new FManII::EvaluationPlan(carts,conns,ff,types,nullptr,
+                                              order));
+    },repeats,r);
+    r.ncoords=count_coords(plan->molecule());
+    results.push_back(r);
+    r.phase="plan "+order_name+" deriv1";
+    FManII::DerivType d;
+    time_phase([&](){d=plan->deriv(1,carts);},repeats,r);
+    results.push_back(r);
+}
+
+///Writes results as a JSON array of objects, one per phase
+inline void write_json(std::ostream& os,const std::vector<BenchResult>& rs){
+    os<<"["<<std::endl;
+    for(size_t i=0;i<rs.size();++i){
+        const BenchResult& r=rs[i];
+        const double rate=r.min_time>0.0?r.ncoords/r.min_time:0.0;
+        os<<"  {\"system\": \""<<r.system<<"\", "
+          <<"\"force_field\": \""<<r.force_field<<"\", "
+          <<"\"phase\": \""<<r.phase<<"\", "
+          <<"\"natoms\": "<<r.natoms<<", "
+          <<"\"ncoords\": "<<r.ncoords<<", "
+          <<"\"nthreads\": "<<r.nthreads<<", "
+          <<"\"repeats\": "<<r.repeats<<", "
+          <<"\"min_time_s\": "<<r.min_time<<", "
+          <<"\"mean_time_s\": "<<r.mean_time<<", "
+          <<"\"coords_per_s\": "<<rate<<", "
+          <<"\"rss_kb\": "<<r.rss_kb<<", "
+          <<"\"peak_rss_kb\": "<<r.peak_rss_kb;
+        for(size_t j=0;j<nperf_events;++j)
+            if(r.counters[j]>=0)
+                os<<", \""<<perf_event_name(j)<<"\": "<<r.counters[j];
+        os<<"}"
+          <<(i+1<rs.size()?",":"")<<std::endl;
+    }
+    os<<"]"<<std::endl;
+}
+
+///Returns the value following \p flag on the command line, or \p def
+inline std::string get_arg(int argc,char** argv,const std::string& flag,
+                           const std::string& def){
+    for(int i=1;i+1<argc;++i)
+        if(flag==argv[i])return argv[i+1];
+    return def;
+}
+
+///True if \p flag was given on the command line
+inline bool has_flag(int argc,char** argv,const std::string& flag){
+    for(int i=1;i<argc;++i)
+        if(flag==argv[i])return true;
+    return false;
+}
+
+///Opens the performance counters if --counters was given, null otherwise
+inline std::unique_ptr<PerfCounters> make_counters(int argc,char** argv){
+    if(!has_flag(argc,argv,"--counters"))return nullptr;
+    std::unique_ptr<PerfCounters> rv(new PerfCounters);
+    if(!rv->available())
+        std::cerr<<"Performance counters are unavailable (see "
+                 <<"/proc/sys/kernel/perf_event_paranoid), only timing the "
+                 <<"kernels"<<std::endl;
+    return rv;
+}
+
+///Splits a comma separated list of sizes, e.g. "1,2,4"
+inline std::vector<size_t> get_list(int argc,char** argv,
+                                    const std::string& flag,
+                                    const std::string& def){
+    std::vector<size_t> rv;
+    std::stringstream ss(get_arg(argc,argv,flag,def));
+    std::string item;
+    while(std::getline(ss,item,','))
+        if(!item.empty())rv.push_back(std::stoul(item));
+    return rv;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "BenchMacros.hpp"
+#include "SystemGenerator.hpp"
+#include <fstream>
+
+using namespace FManII;
+using namespace std;
+
+/* Usage: BenchScaling [--kind water|peptide] [--ff AMBER99|OPLSAA]
+ *                     [--sizes 1000,2000,...] [--threads 1,2,...]
+ *                     [--repeats N] [--max-pairs N] [--output file.json]
+ *                     [--counters] [--atom-order input|morton|hilbert]
+ *
+ * Generates systems of each size and times each phase of a ForceManII
+ * computation on them with each number of threads.  Every pair of atoms is
+ * an internal coordinate, so sizes with more than --max-pairs pairs are
+ * skipped rather than running out of memory.  --counters works as it does
+ * for BenchTestSystems.  With --atom-order the gradient is also computed
+ * through an EvaluationPlan that numbers the atoms that way.
+ */
+int main(int argc, char** argv){
+    const string kind=get_arg(argc,argv,"--kind","water"),
+                 ff_name=get_arg(argc,argv,"--ff","AMBER99"),
+                 output=get_arg(argc,argv,"--output","");
+    const vector<size_t> sizes=get_list(argc,argv,"--sizes",
+                                        "1000,2000,4000,8000"),
+                         threads=get_list(argc,argv,"--threads","1,2,4");
+    const size_t repeats=stoul(get_arg(argc,argv,"--repeats","3")),
+                 max_pairs=stoul(get_arg(argc,argv,"--max-pairs","200000000"));
+    const ForceField& ff=get_ff(ff_name);
+    unique_ptr<PerfCounters> counters=make_counters(argc,argv);
+    const string order_name=get_arg(argc,argv,"--atom-order","");
+    const map<string,AtomOrder> orders={{"input",AtomOrder::INPUT},
+                                        {"morton",AtomOrder::MORTON},
+                                        {"hilbert",AtomOrder::HILBERT}};
+    if(!order_name.empty() && !orders.count(order_name)){
+        cerr<<"Unknown --atom-order "<<order_name<<endl;
+        return 1;
+    }
+
+    vector<BenchResult> results;
+    for(size_t natoms:sizes){
+        const GeneratedSystem sys=generate(kind,ff_name,natoms);
+        const size_t n=sys.types.size();
+        if(n*(n-1)/2>max_pairs){
+            cerr<<"Skipping "<<sys.name<<", its "<<n*(n-1)/2<<" pairs exceed "
+                <<"--max-pairs"<<endl;
+            continue;
+        }
+        for(size_t nthreads:threads){
+            set_num_threads(nthreads);
+            BenchResult base;
+            base.system=sys.name;
+            base.force_field=ff_name;
+            base.natoms=n;
+            base.nthreads=get_num_threads();
+            bench_phases(base,sys.carts,sys.conns,ff,sys.types,repeats,
+                         results,counters.get());
+            if(!order_name.empty())
+                bench_plan(base,sys.carts,sys.conns,ff,sys.types,
+                           orders.at(order_name),order_name,repeats,results);
+        }
+    }
+
+    if(output.empty())write_json(cout,results);
+    else{
+        ofstream file(output);
+        write_json(file,results);
+    }
+    return 0;
+} //End main
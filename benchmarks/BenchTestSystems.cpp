@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "BenchMacros.hpp"
+#include "testdata/crambin.hpp"
+#include "testdata/peptide.hpp"
+#include "testdata/ubiquitin.hpp"
+#include <fstream>
+
+using namespace FManII;
+using namespace std;
+
+//A molecule from tests/testdata and the force field its types are for
+struct TestSystem{
+    string name,ff_name;
+    const Vector& carts;
+    const ConnData& conns;
+    const IVector& types;
+};
+
+/* Usage: BenchTestSystems [--repeats N] [--threads N] [--output file.json]
+ *                         [--trace trace.json] [--counters]
+ *
+ * Times each phase of a ForceManII computation on the molecules used by the
+ * unit tests and writes the results as JSON (to stdout by default).  With
+ * --trace, and a library built with ENABLE_PROFILING, a Chrome trace of the
+ * whole run is also written.  With --counters each kernel is also timed on
+ * its own and the CPU's performance counters are read around everything.
+ */
+int main(int argc, char** argv){
+    const size_t repeats=stoul(get_arg(argc,argv,"--repeats","5"));
+    const string output=get_arg(argc,argv,"--output","");
+    const string trace=get_arg(argc,argv,"--trace","");
+    unique_ptr<PerfCounters> counters=make_counters(argc,argv);
+    set_num_threads(stoul(get_arg(argc,argv,"--threads","1")));
+
+    const vector<TestSystem> systems({
+        {"ubiquitin","AMBER99",ubiquitin,ubiquitin_conns,ubiquitin_FF_types},
+        {"crambin","CHARMM22",crambin,crambin_conns,crambin_FF_types},
+        {"peptide","OPLSAA",peptide,peptide_conns,peptide_FF_types}});
+
+    vector<BenchResult> results;
+    if(!trace.empty())start_trace();
+    for(const TestSystem& sys:systems){
+        BenchResult base;
+        base.system=sys.name;
+        base.force_field=sys.ff_name;
+        base.natoms=sys.carts.size()/3;
+        base.nthreads=get_num_threads();
+        bench_phases(base,sys.carts,sys.conns,get_ff(sys.ff_name),sys.types,
+                     repeats,results,counters.get());
+    }
+
+    if(!trace.empty()){
+        stop_trace();
+        ofstream file(trace);
+        write_trace(file);
+    }
+    if(output.empty())write_json(cout,results);
+    else{
+        ofstream file(output);
+        write_json(file,results);
+    }
+    return 0;
+} //End main
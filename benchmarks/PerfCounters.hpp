@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+
+#pragma once
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <array>
+#include <cstring>
+#include <string>
+
+///Number of hardware events PerfCounters reads
+constexpr size_t nperf_events=4;
+
+///Counts of each event, -1 for events the hardware/kernel can't count
+using PerfCounts=std::array<long long,nperf_events>;
+
+///The name of each event, as it appears in the JSON output
+inline const char* perf_event_name(size_t i){
+    static const char* names[nperf_events]=
+        {"cycles","instructions","cache_misses","branch_misses"};
+    return names[i];
+}
+
+/** \brief Reads the CPU's performance counters via Linux's perf_event_open
+ *
+ *  The counters count user-space work of the calling thread and of any
+ *  threads it starts while they run, so phases that use parallel_for are
+ *  counted in full.  If the
+ *  kernel doesn't allow it (see /proc/sys/kernel/perf_event_paranoid) or the
+ *  CPU isn't exposed (e.g. many virtual machines), available() is false and
+ *  all counts are -1.
+ */
+class PerfCounters{
+    std::array<int,nperf_events> fds_;
+    PerfCounts start_;///<The counts when start() was called
+
+    ///The current total of each event, -1 if it isn't counted
+    PerfCounts read_counts()const{
+        PerfCounts rv;
+        rv.fill(-1);
+        for(size_t i=0;i<nperf_events;++i){
+            long long count=0;
+            if(fds_[i]>=0 && read(fds_[i],&count,sizeof(count))==sizeof(count))
+                rv[i]=count;
+        }
+        return rv;
+    }
+public:
+    PerfCounters(){
+        static const unsigned long long configs[nperf_events]={
+            PERF_COUNT_HW_CPU_CYCLES,PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES,PERF_COUNT_HW_BRANCH_MISSES};
+        fds_.fill(-1);
+        start_.fill(0);
+        for(size_t i=0;i<nperf_events;++i){
+            perf_event_attr attr;
+            std::memset(&attr,0,sizeof(attr));
+            attr.size=sizeof(attr);
+            attr.type=PERF_TYPE_HARDWARE;
+            attr.config=configs[i];
+            attr.disabled=1;
+            attr.exclude_kernel=1;
+            attr.exclude_hv=1;
+            attr.inherit=1;
+            fds_[i]=syscall(__NR_perf_event_open,&attr,0,-1,-1,0);
+        }
+    }
+    ~PerfCounters(){
+        for(int fd:fds_)if(fd>=0)close(fd);
+    }
+    PerfCounters(const PerfCounters&)=delete;
+    PerfCounters& operator=(const PerfCounters&)=delete;
+
+    ///True if at least one of the events can be counted
+    bool available()const{
+        for(int fd:fds_)if(fd>=0)return true;
+        return false;
+    }
+
+    /** \brief Starts the counters
+     *
+     *  PERF_EVENT_IOC_RESET only zeroes the calling thread's own count, not
+     *  what threads that have since exited added to it, so rather than
+     *  resetting, the totals so far are kept and subtracted by stop().
+     */
+    void start(){
+        start_=read_counts();
+        for(int fd:fds_)if(fd>=0)ioctl(fd,PERF_EVENT_IOC_ENABLE,0);
+    }
+
+    ///Stops the counters and returns what they counted since start()
+    PerfCounts stop(){
+        for(int fd:fds_)if(fd>=0)ioctl(fd,PERF_EVENT_IOC_DISABLE,0);
+        PerfCounts rv=read_counts();
+        for(size_t i=0;i<nperf_events;++i)
+            if(rv[i]>=0 && start_[i]>=0)rv[i]-=start_[i];
+            else rv[i]=-1;
+        return rv;
+    }
+};
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include "SystemGenerator.hpp"
+#include "testdata/peptide.hpp"
+#include "testdata/ubiquitin.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <set>
+#include <stdexcept>
+
+using namespace FManII;
+using namespace std;
+
+namespace {
+const double ang2au=1.889725989;
+//TIP3P geometry and the grid spacing that gives about 1 g/cm^3
+const double r_oh=0.9572*ang2au,theta_hoh=104.52*M_PI/180.0,
+             spacing=3.104*ang2au;
+
+//The smallest n such that n^3>=ncopies
+size_t grid_size(size_t ncopies){
+    size_t n=1;
+    while(n*n*n<ncopies)++n;
+    return n;
+}
+
+//Appends a copy of a molecule shifted by (dx,dy,dz)
+void append(GeneratedSystem& sys,const Vector& carts,const ConnData& conns,
+            const IVector& types,const array<double,3>& shift){
+    const size_t offset=sys.types.size();
+    for(size_t i=0;i<carts.size();++i)sys.carts.push_back(carts[i]+shift[i%3]);
+    for(const auto& bonded:conns){
+        set<size_t> shifted;
+        for(size_t j:bonded)shifted.insert(j+offset);
+        sys.conns.push_back(shifted);
+    }
+    sys.types.insert(sys.types.end(),types.begin(),types.end());
+}
+}//End anonymous namespace
+
+GeneratedSystem water_box(size_t nwaters,const string& ff,unsigned seed){
+    IVector types;
+    if(ff=="AMBER99")types={2001,2002,2002};
+    else if(ff=="OPLSAA")types={63,64,64};
+    else throw runtime_error("No water types for force field "+ff);
+    const ConnData conns({{1,2},{0},{0}});
+
+    const size_t n=grid_size(nwaters);
+    GeneratedSystem sys;
+    sys.name=to_string(nwaters)+" "+ff+" waters";
+    sys.box={n*spacing,n*spacing,n*spacing};
+    mt19937 gen(seed);
+    normal_distribution<double> normal;
+    for(size_t w=0;w<nwaters;++w){
+        //A random rotation from a random unit quaternion
+        array<double,4> q;
+        double norm=0.0;
+        for(double& qi:q){qi=normal(gen);norm+=qi*qi;}
+        for(double& qi:q)qi/=std::sqrt(norm);
+        const double a=q[0],b=q[1],c=q[2],d=q[3];
+        const array<double,9> R={a*a+b*b-c*c-d*d,2*(b*c-a*d),2*(b*d+a*c),
+                                 2*(b*c+a*d),a*a-b*b+c*c-d*d,2*(c*d-a*b),
+                                 2*(b*d-a*c),2*(c*d+a*b),a*a-b*b-c*c+d*d};
+        const Vector body({0.0,0.0,0.0,r_oh,0.0,0.0,
+                           r_oh*std::cos(theta_hoh),r_oh*std::sin(theta_hoh),
+                           0.0});
+        Vector water(9);
+        for(size_t atom=0;atom<3;++atom)
+            for(size_t i=0;i<3;++i)
+                for(size_t j=0;j<3;++j)
+                    water[atom*3+i]+=R[i*3+j]*body[atom*3+j];
+        append(sys,water,conns,types,{(w%n)*spacing,(w/n%n)*spacing,
+                                      (w/(n*n))*spacing});
+    }
+    return sys;
+}
+
+GeneratedSystem replicate(const string& name,const Vector& carts,
+                          const ConnData& conns,const IVector& types,
+                          size_t ncopies){
+    //Copies are spaced by the molecule's extent plus 3 Angstroms
+    array<double,3> lo={1e300,1e300,1e300},hi={-1e300,-1e300,-1e300};
+    for(size_t i=0;i<carts.size();++i){
+        lo[i%3]=min(lo[i%3],carts[i]);
+        hi[i%3]=max(hi[i%3],carts[i]);
+    }
+    array<double,3> width;
+    for(size_t i=0;i<3;++i)width[i]=hi[i]-lo[i]+3.0*ang2au;
+    const size_t n=grid_size(ncopies);
+    GeneratedSystem sys;
+    sys.name=to_string(ncopies)+" copies of "+name;
+    sys.box={n*width[0],n*width[1],n*width[2]};
+    for(size_t c=0;c<ncopies;++c)
+        append(sys,carts,conns,types,{(c%n)*width[0],(c/n%n)*width[1],
+                                      (c/(n*n))*width[2]});
+    return sys;
+}
+
+GeneratedSystem generate(const string& kind,const string& ff,size_t natoms){
+    if(kind=="water")return water_box(max<size_t>(natoms/3,1),ff);
+    if(kind!="peptide")throw runtime_error("Unknown kind of system "+kind);
+    if(ff=="AMBER99"){
+        const size_t size=ubiquitin_FF_types.size();
+        return replicate("ubiquitin",ubiquitin,ubiquitin_conns,
+                         ubiquitin_FF_types,max<size_t>(natoms/size,1));
+    }
+    if(ff=="OPLSAA"){
+        const size_t size=peptide_FF_types.size();
+        return replicate("peptide",peptide,peptide_conns,peptide_FF_types,
+                         max<size_t>(natoms/size,1));
+    }
+    throw runtime_error("No peptide with types for force field "+ff);
+}
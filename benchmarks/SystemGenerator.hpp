@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#pragma once
+#include <ForceManII/FManII.hpp>
+#include <array>
+#include <string>
+
+///A system made by one of the generators
+struct GeneratedSystem{
+    std::string name;///<A description of the system
+    FManII::Vector carts;///<Cartesian coordinates in a.u.
+    FManII::ConnData conns;///<The bonds
+    FManII::IVector types;///<Atom types for the force field requested
+    std::array<double,3> box;///<Edge lengths, in a.u., of the box it fills
+};
+
+/** \brief Makes a cubic box of TIP3P water at about liquid density
+ *
+ *  Molecules sit on a cubic grid with random orientations.
+ *
+ *  \param[in] nwaters The number of water molecules
+ *  \param[in] ff Which force field's atom types to use, "AMBER99" or "OPLSAA"
+ *  \param[in] seed Seeds the random orientations
+ */
+GeneratedSystem water_box(size_t nwaters,const std::string& ff,
+                          unsigned seed=1);
+
+/** \brief Places copies of a molecule on a cubic grid
+ *
+ *  \param[in] name What to call the system
+ *  \param[in] carts,conns,types The molecule to copy
+ *  \param[in] ncopies How many copies to make
+ */
+GeneratedSystem replicate(const std::string& name,
+                          const FManII::Vector& carts,
+                          const FManII::ConnData& conns,
+                          const FManII::IVector& types,
+                          size_t ncopies);
+
+/** \brief Makes a system with about \p natoms atoms
+ *
+ *  \param[in] kind "water" for a water box, "peptide" for copies of the test
+ *                  protein with types for \p ff (ubiquitin for AMBER99, the
+ *                  peptide for OPLSAA)
+ *  \param[in] ff "AMBER99" or "OPLSAA"
+ *  \param[in] natoms Roughly how many atoms to make, the system is made of
+ *                    whole molecules
+ */
+GeneratedSystem generate(const std::string& kind,const std::string& ff,
+                         size_t natoms);
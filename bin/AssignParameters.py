@@ -130,9 +130,11 @@ def compute_pairs(carts,atom2tink,connect,param_num,parms):
                 ei=parms[v12type][params["epsilon"]][(atom2tink[param_num[i]],)][0]
                 sj=parms[v12type][params["sigma"]][(atom2tink[param_num[j]],)][0]
                 ej=parms[v12type][params["epsilon"]][(atom2tink[param_num[j]],)][0]
+            #6-12 parameters are assigned as A/r**12-B/r**6
+            eij,sij=math.sqrt(ei*ej),0.5*(si+sj)
             ps[0][itype].append(qi*qj)
-            ps[1][itype].append(math.sqrt(ei*ej))
-            ps[2][itype].append(0.5*(si+sj))
+            ps[1][itype].append(eij*sij**12)
+            ps[2][itype].append(2.0*eij*sij**6)
     return ps[0],ps[1],ps[2]
 
 
@@ -176,13 +178,13 @@ def main():
     foundparams[ffterm][params["n"]]=n
 
 
-    qs,es,ss=compute_pairs(carts,ff.type2class,connect,param_num,ff.params)
+    qs,As,Bs=compute_pairs(carts,ff.type2class,connect,param_num,ff.params)
     for itype in ["pair14","pair"]:
         ctype=(models["cl"],intcoords[itype])
         vtype=(models["lj"],intcoords[itype])
         foundparams[ctype][params["q"]]=qs[itype]
-        foundparams[vtype][params["epsilon"]]=es[itype]
-        foundparams[vtype][params["sigma"]]=ss[itype]
+        foundparams[vtype][params["A"]]=As[itype]
+        foundparams[vtype][params["B"]]=Bs[itype]
 
     f=open(mol_name+"_params.hpp","w")
     f.write("//This file is autogenerated from AssignParameters.py\n\n")
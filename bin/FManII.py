@@ -20,7 +20,9 @@ params={"k":"FManII::Param_t::K",
         "n":"FManII::Param_t::n",
         "q":"FManII::Param_t::q",
         "sigma":"FManII::Param_t::sigma",
-        "epsilon":"FManII::Param_t::epsilon"
+        "epsilon":"FManII::Param_t::epsilon",
+        "A":"FManII::Param_t::A",
+        "B":"FManII::Param_t::B"
 }
 
 #Recognized internal coordinate types
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include "TestMacros.hpp"
+#include "testdata/peptide.hpp"
+
+using namespace std;
+using namespace FManII;
+
+int main(int argc, char** argv){
+    test_header("Testing contiguous storage of atom tuples");
+    AtomTuples angles;
+    test_value(angles.arity(),size_t(0),"Arity unknown when empty");
+    angles.push_back({0,1,2});
+    angles.push_back(IVector({3,4,5}));
+    test_value(angles.arity(),size_t(3),"Arity set by first coordinate");
+    test_value(angles.size(),size_t(2),"Number of coordinates");
+    test_value(angles.data()==vector<Index_t>({0,1,2,3,4,5}),true,
+               "Atoms are stored back to back");
+    test_value(angles[1][2],size_t(5),"Element access");
+    const IVector bond({0,1});
+    TEST_THROW(angles.push_back(bond),"Arity must not change");
+    size_t n=0;
+    for(const AtomTuple a:angles){
+        test_value(a.size(),size_t(3),"Iterated tuple size");
+        test_value(a[0],3*n++,"Iterated tuple atoms");
+    }
+    test_value(n,size_t(2),"Iterates over every coordinate");
+
+    //get_coords should give each type of coordinate one array
+    const Molecule mol=get_coords(peptide,peptide_conns);
+    const map<string,size_t> arities={
+        {IntCoord_t::BOND,2},{IntCoord_t::PAIR13,3},{IntCoord_t::PAIR14,2},
+        {IntCoord_t::PAIR,2},{IntCoord_t::ANGLE,3},{IntCoord_t::TORSION,4},
+        {IntCoord_t::IMPTORSION,4}};
+    for(const auto& ci:mol.atom_numbers){
+        test_value(ci.second.arity(),arities.at(ci.first),ci.first+" arity");
+        test_value(ci.second.data().size(),
+                   ci.second.size()*arities.at(ci.first),ci.first+" storage");
+        test_value(ci.second.size(),mol.coords.at(ci.first).size(),
+                   ci.first+" has a value per coordinate");
+    }
+
+    //The compressed bonds have the same neighbors and give the same system
+    const Connectivity csr(peptide_conns);
+    test_value(csr.size(),peptide_conns.size(),"Connectivity atoms");
+    bool same=true;
+    for(size_t i=0;i<csr.size();++i){
+        const Connectivity::Neighbors ns=csr.neighbors(i);
+        same=same && IVector(ns.begin(),ns.end())==
+                     IVector(peptide_conns[i].begin(),peptide_conns[i].end());
+    }
+    test_value(same,true,"Connectivity neighbors");
+    test_value(csr.bonded(0,*peptide_conns[0].begin()),true,"Bonded atoms");
+    test_value(csr.bonded(0,0),false,"Atoms aren't bonded to themselves");
+    const Molecule mol2=get_coords(peptide,csr);
+    for(const auto& ci:mol.atom_numbers){
+        test_value(mol2.atom_numbers.at(ci.first).data()==ci.second.data(),
+                   true,ci.first+" from compressed bonds");
+        compare_vectors(mol2.coords.at(ci.first),mol.coords.at(ci.first),0.0,
+                        ci.first+" values from compressed bonds");
+    }
+    const ConnData bad({{1},{2}});
+    TEST_THROW(Connectivity{bad},"Bonds to missing atoms");
+
+    test_footer();
+    return 0;
+} //End main
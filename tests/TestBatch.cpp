@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include "TestMacros.hpp"
+#include "testdata/crambin.hpp"
+
+using namespace std;
+using namespace FManII;
+
+int main(int argc, char** argv){
+    test_header("Testing batches of geometries");
+    const size_t n=crambin.size(),nframes=5;
+    Vector frames;
+    for(size_t f=0;f<nframes;++f)
+        for(size_t i=0;i<n;++i)
+            frames.push_back(crambin[i]+0.05*f*std::sin(0.7*i+f));
+
+    //Each frame the slow way
+    EvaluationPlan plan(crambin,crambin_conns,charmm22,crambin_FF_types,nullptr,
+                        AtomOrder::HILBERT);
+    Vector corr_egy(nframes,0.0),corr_grad;
+    for(size_t f=0;f<nframes;++f){
+        const Vector carts(frames.begin()+f*n,frames.begin()+(f+1)*n);
+        for(const auto& di:plan.deriv(0,carts))corr_egy[f]+=di.second[0];
+        Vector grad(n,0.0);
+        plan.add_gradient(grad);
+        corr_grad.insert(corr_grad.end(),grad.begin(),grad.end());
+    }
+    plan.set_coords(crambin);
+
+    Vector first_egy,first_grad;
+    for(size_t nthreads:{1,2,4}){
+        set_num_threads(nthreads);
+        const string threads=" with "+to_string(nthreads)+" threads";
+        Vector grads;
+        const Vector egys=plan.batch(frames,&grads);
+        compare_vectors(egys,corr_egy,1e-8,"Energies"+threads);
+        compare_vectors(grads,corr_grad,1e-10,"Gradients"+threads);
+        compare_vectors(plan.batch(frames),egys,1e-8,"Energies only"+threads);
+        if(nthreads==1){
+            first_egy=egys;
+            first_grad=grads;
+            continue;
+        }
+        compare_vectors(egys,first_egy,0.0,"Energies independent"+threads);
+        compare_vectors(grads,first_grad,0.0,"Gradients independent"+threads);
+    }
+    set_num_threads(1);
+    Vector grad(n,0.0);
+    plan.add_gradient(grad);
+    compare_vectors(grad,Vector(corr_grad.begin(),corr_grad.begin()+n),1e-10,
+                    "Batch leaves the plan's geometry alone");
+    test_value(plan.batch(Vector()).size(),size_t(0),"Empty batch");
+    TEST_THROW(plan.batch(Vector(n+1)),"Partial frames are an error");
+
+    test_footer();
+    return 0;
+} //End main
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include <ForceManII/InternalCoords/Angle.hpp>
+#include "TestMacros.hpp"
+#include "testdata/crambin.hpp"
+
+using namespace std;
+using namespace FManII;
+
+int main(int argc, char** argv){
+    test_header("Testing bond vectors");
+    const Vector water({0.0,0.0,0.0,1.8,0.2,0.0,-0.4,1.75,0.0});
+    AtomTuples bonds(2);
+    bonds.push_back({0,1});
+    bonds.push_back({2,0});
+    const BondVectors bv(water,bonds,nullptr);
+    test_value(bv.size(),size_t(2),"One vector per bond");
+    compare_vectors(Vector({bv.vector(1)[0],bv.vector(1)[1],bv.vector(1)[2]}),
+                    Vector({-0.4,1.75,0.0}),1e-14,"Bond vector is qi-qj");
+    compare_vectors(bv.lengths(),Vector({std::sqrt(3.28),std::sqrt(3.2225)}),
+                    1e-14,"Bond lengths");
+
+    //Angle 1-0-2 needs q1-q0, the first bond, and q2-q0, the second reversed
+    AtomTuples angles(3);
+    angles.push_back({1,0,2});
+    BondRefs refs;
+    test_value(BondRefs::find(IntCoord_t::ANGLE,angles,bonds,3,refs),true,
+               "Found the bonds of an angle");
+    test_value(refs.size(),size_t(1),"One angle");
+    Vector theta(1),dtheta(9);
+    refs.deriv(0,bv,0,theta.data());
+    refs.deriv(1,bv,0,dtheta.data());
+    compare_vectors(theta,Angle().deriv(0,water,angles[0]),1e-14,"Angle value");
+    compare_vectors(dtheta,Angle().deriv(1,water,angles[0]),1e-14,
+                    "Angle gradient");
+    AtomTuples not_bonded(3);
+    not_bonded.push_back({0,1,2});
+    test_value(BondRefs::find(IntCoord_t::ANGLE,not_bonded,bonds,3,refs),false,
+               "Atoms 1 and 2 aren't bonded");
+    test_value(refs.size(),size_t(1),"Failed search leaves refs alone");
+    test_value(BondRefs::find(IntCoord_t::BOND,bonds,bonds,3,refs),false,
+               "Only angles, torsions, and impropers are made of bonds");
+
+    //Every bonded coordinate of a protein against its own kernel
+    Vector moved(crambin);
+    for(size_t i=0;i<moved.size();++i)moved[i]+=0.05*std::sin(1.0*i);
+    Molecule mol=get_coords(crambin,crambin_conns);
+    update_coords(mol,moved);
+    const Molecule fresh=get_coords(moved,crambin_conns);
+    test_value(mol.bond_vectors.size(),mol.atom_numbers.at(IntCoord_t::BOND).size(),
+               "get_coords computes the bond vectors");
+    for(const auto& type:{IntCoord_t::ANGLE,IntCoord_t::TORSION,
+                          IntCoord_t::IMPTORSION}){
+        test_value(mol.bond_refs.count(type),size_t(1),
+                   string("get_coords finds the bonds of ")+type);
+        const BondRefs& type_refs=mol.bond_refs.at(type);
+        const AtomTuples& coords=mol.atom_numbers.at(type);
+        const auto coord=get_intcoord(type);
+        const size_t n=3*coords[0].size();
+        Vector values(coords.size()),grads(n*coords.size()),
+               corr_values(coords.size()),corr_grads(n*coords.size());
+        for(size_t i=0;i<coords.size();++i){
+            type_refs.deriv(0,mol.bond_vectors,i,&values[i]);
+            type_refs.deriv(1,mol.bond_vectors,i,&grads[n*i]);
+            corr_values[i]=coord->deriv(0,moved,coords[i])[0];
+            const Vector g=coord->deriv(1,moved,coords[i]);
+            copy(g.begin(),g.end(),&corr_grads[n*i]);
+        }
+        compare_vectors(values,corr_values,1e-12,string(type)+" values");
+        compare_vectors(grads,corr_grads,1e-10,string(type)+" gradients");
+        compare_vectors(mol.coords.at(type),fresh.coords.at(type),1e-12,
+                        string("update_coords ")+type);
+    }
+    compare_vectors(mol.coords.at(IntCoord_t::BOND),
+                    fresh.coords.at(IntCoord_t::BOND),1e-12,
+                    "update_coords BOND");
+
+    //Dropping coordinates without indexing the bonds again is caught
+    const ParamSet ps=assign_params(fresh,charmm22,crambin_FF_types);
+    Molecule stale=fresh;
+    stale.atom_numbers[IntCoord_t::ANGLE]=AtomTuples(3);
+    stale.coords[IntCoord_t::ANGLE]=Vector();
+    stale.colors.clear();
+    ParamSet no_angles=ps;
+    for(auto& pi:no_angles)
+        if(pi.first.second==IntCoord_t::ANGLE)
+            for(auto& p:pi.second)p.second.clear();
+    TEST_THROW(deriv(1,charmm22,no_angles,stale),"Stale bond references");
+    index_bonds(stale);
+    test_value(stale.bond_refs.at(IntCoord_t::ANGLE).size(),size_t(0),
+               "index_bonds updates the references");
+
+    test_footer();
+    return 0;
+} //End main
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include "TestMacros.hpp"
+#include "testdata/crambin.hpp"
+
+using namespace std;
+using namespace FManII;
+
+//True if each coordinate has one color and no two of a color share an atom
+bool valid_coloring(const Coloring& colors,const AtomTuples& tuples,
+                    size_t natoms){
+    vector<size_t> seen(tuples.size(),0);
+    for(size_t c=0;c<colors.ncolors();++c){
+        vector<bool> used(natoms,false);
+        for(size_t i:colors.color(c)){
+            ++seen[i];
+            for(size_t ai:tuples[i]){
+                if(used[ai])return false;
+                used[ai]=true;
+            }
+        }
+    }
+    return seen==vector<size_t>(tuples.size(),1);
+}
+
+int main(int argc, char** argv){
+    test_header("Testing coloring of internal coordinates");
+    AtomTuples chain(2);
+    for(size_t i=0;i<4;++i)chain.push_back({i,i+1});
+    const Coloring chain_colors(chain,5);
+    test_value(chain_colors.size(),size_t(4),"Every bond colored");
+    test_value(chain_colors.ncolors(),size_t(2),"A chain needs two colors");
+    test_value(vector<Index_t>(chain_colors.color(0).begin(),
+                               chain_colors.color(0).end()),
+               vector<Index_t>({0,2}),"First color");
+    test_value(vector<Index_t>(chain_colors.color(1).begin(),
+                               chain_colors.color(1).end()),
+               vector<Index_t>({1,3}),"Second color");
+    test_value(Coloring(AtomTuples(2),5).ncolors(),size_t(0),"No coordinates");
+    TEST_THROW(Coloring(chain,4),"Atoms must exist");
+
+    //Every bond of a star shares atom 0, so each needs its own color
+    AtomTuples star(2);
+    for(size_t i=1;i<=100;++i)star.push_back({0,i});
+    test_value(Coloring(star,101).ncolors(),size_t(100),"More than 64 colors");
+
+    Molecule mol=get_coords(crambin,crambin_conns);
+    const size_t natoms=crambin.size()/3;
+    for(const auto& type:{IntCoord_t::BOND,IntCoord_t::ANGLE,
+                          IntCoord_t::TORSION,IntCoord_t::IMPTORSION}){
+        test_value(mol.colors.count(type),size_t(1),
+                   string("get_coords colors ")+type);
+        test_value(valid_coloring(mol.colors.at(type),
+                                  mol.atom_numbers.at(type),natoms),
+                   true,string("Valid coloring of ")+type);
+    }
+    test_value(mol.colors.count(IntCoord_t::PAIR),size_t(0),"Pairs not colored");
+
+    //Colored scatter, serial and threaded, against the uncolored gradient
+    const ParamSet ps=assign_params(mol,charmm22,crambin_FF_types);
+    const DerivType colored=deriv(1,charmm22,ps,mol);
+    set_num_threads(4);
+    const DerivType colored4=deriv(1,charmm22,ps,mol);
+    set_num_threads(1);
+    Molecule plain=mol;
+    plain.colors.clear();
+    const DerivType grad=deriv(1,charmm22,ps,plain);
+    for(const auto& gi:grad){
+        const string msg=gi.first.first+" "+gi.first.second;
+        compare_vectors(colored.at(gi.first),gi.second,1e-12,msg+" colored");
+        if(mol.colors.count(gi.first.second))
+            compare_vectors(colored4.at(gi.first),colored.at(gi.first),0.0,
+                            msg+" independent of threads");
+    }
+    plain.colors[IntCoord_t::BOND]=Coloring();
+    TEST_THROW(deriv(1,charmm22,ps,plain),"Stale colorings are caught");
+
+    test_footer();
+    return 0;
+} //End main
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include "TestMacros.hpp"
+#include "testdata/crambin.hpp"
+
+using namespace std;
+using namespace FManII;
+
+int main(int argc, char** argv){
+    test_header("Testing energy-only evaluation");
+    const Molecule mol=get_coords(crambin,crambin_conns);
+    const ParamSet ps=assign_params(mol,charmm22,crambin_FF_types);
+
+    //Values straight from the geometry, with and without a small box
+    const Cell box(25.0,30.0,35.0);
+    for(const auto& ci:mol.atom_numbers){
+        const auto coord=get_intcoord(ci.first);
+        Vector corr,test,corr_pbc,test_pbc;
+        for(const AtomTuple atoms:ci.second){
+            corr.push_back(coord->deriv(0,crambin,atoms,nullptr)[0]);
+            test.push_back(coord->value(crambin,atoms,nullptr));
+            corr_pbc.push_back(coord->deriv(0,crambin,atoms,&box)[0]);
+            test_pbc.push_back(coord->value(crambin,atoms,&box));
+        }
+        compare_vectors(test,corr,1e-12,ci.first+" values");
+        compare_vectors(test_pbc,corr_pbc,1e-12,ci.first+" periodic values");
+    }
+
+    const DerivType corr=deriv(0,charmm22,ps,mol);
+    for(size_t nthreads:{1,3}){
+        set_num_threads(nthreads);
+        const string threads=" with "+to_string(nthreads)+" threads";
+        const EnergyType test=energy(charmm22,ps,mol);
+        test_value(test.size(),corr.size(),"Energy of each term"+threads);
+        for(const auto& di:corr)
+            test_value(test.at(di.first),di.second[0],1e-10,
+                       di.first.first+" "+di.first.second+threads);
+    }
+    set_num_threads(1);
+
+    //Another geometry without updating the molecule
+    Vector moved(crambin);
+    for(size_t i=0;i<moved.size();++i)moved[i]+=0.02*std::sin(0.9*i);
+    const Molecule mol2=get_coords(moved,crambin_conns);
+    const DerivType corr2=deriv(0,charmm22,ps,mol2);
+    const EnergyType test2=energy(charmm22,ps,mol,nullptr,&moved);
+    for(const auto& di:corr2)
+        test_value(test2.at(di.first),di.second[0],1e-10,
+                   "Other geometry "+di.first.first+" "+di.first.second);
+    TEST_THROW(energy(charmm22,ps,mol,nullptr,&corr.begin()->second),
+               "Geometry must have the same atoms");
+
+    const TermFilter angles=only_term(Terms_t::HO_ANGLE);
+    const EnergyType some=energy(charmm22,ps,mol,angles);
+    test_value(some.size(),size_t(1),"Filtered terms");
+    test_value(some.at(Terms_t::HO_ANGLE),corr.at(Terms_t::HO_ANGLE)[0],1e-12,
+               "Filtered energy");
+
+    //Through a plan that renumbers the atoms; the plan isn't moved
+    const EvaluationPlan plan(crambin,crambin_conns,charmm22,crambin_FF_types,
+                              nullptr,AtomOrder::HILBERT);
+    const EnergyType test3=plan.energy(moved);
+    for(const auto& di:corr2)
+        test_value(test3.at(di.first),di.second[0],1e-10,
+                   "Plan "+di.first.first+" "+di.first.second);
+    const DerivType still=plan.deriv(0);
+    for(const auto& di:corr)
+        test_value(still.at(di.first)[0],di.second[0],1e-10,
+                   "Plan keeps its geometry "+di.first.first+" "+
+                   di.first.second);
+
+    test_footer();
+    return 0;
+} //End main
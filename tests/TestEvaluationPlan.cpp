@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include "TestMacros.hpp"
+#include "testdata/crambin.hpp"
+#include <algorithm>
+
+using namespace std;
+using namespace FManII;
+
+int main(int argc, char** argv){
+    test_header("Testing evaluation plans and atom reordering");
+
+    //The first 64 points of a Hilbert curve fill the 4x4x4 corner of the grid
+    //one step at a time
+    vector<pair<uint64_t,array<uint32_t,3>>> pts;
+    for(uint32_t x=0;x<4;++x)
+        for(uint32_t y=0;y<4;++y)
+            for(uint32_t z=0;z<4;++z)
+                pts.push_back({detail::hilbert_key(x,y,z),{{x,y,z}}});
+    sort(pts.begin(),pts.end());
+    bool steps=true;
+    for(size_t i=0;i<pts.size();++i){
+        steps=steps && pts[i].first==i;
+        if(!i)continue;
+        uint32_t dist=0;
+        for(size_t x=0;x<3;++x)
+            dist+=max(pts[i].second[x],pts[i-1].second[x])-
+                  min(pts[i].second[x],pts[i-1].second[x]);
+        steps=steps && dist==1;
+    }
+    test_value(steps,true,"Hilbert curve takes unit steps");
+    test_value(detail::morton_key(1,0,0),uint64_t(4),"Morton key x bit");
+    test_value(detail::morton_key(0,1,1),uint64_t(3),"Morton key y and z bits");
+    test_value(detail::morton_key(2,0,0),uint64_t(32),"Morton key second bit");
+
+    const IVector input=curve_order(crambin,AtomOrder::INPUT);
+    test_value(input[10],size_t(10),"Input order is unchanged");
+    for(AtomOrder order:{AtomOrder::MORTON,AtomOrder::HILBERT}){
+        IVector sorted=curve_order(crambin,order);
+        test_value(sorted==input,false,"Curve renumbers the atoms");
+        sort(sorted.begin(),sorted.end());
+        test_value(sorted==input,true,"Curve order is a permutation");
+    }
+
+    //Plans give what run_forcemanii does, in the caller's numbering
+    Vector moved(crambin);
+    for(size_t i=0;i<moved.size();++i)moved[i]+=0.01*std::sin(double(i));
+    const DerivType egy=run_forcemanii(0,crambin,crambin_conns,charmm22,
+                                       crambin_FF_types),
+                    grad=run_forcemanii(1,moved,crambin_conns,charmm22,
+                                        crambin_FF_types);
+    for(AtomOrder order:{AtomOrder::INPUT,AtomOrder::MORTON,AtomOrder::HILBERT}){
+        EvaluationPlan plan(crambin,crambin_conns,charmm22,crambin_FF_types,
+                            nullptr,order);
+        const string name=order==AtomOrder::INPUT?"input":
+                          order==AtomOrder::MORTON?"Morton":"Hilbert";
+        test_value(plan.atom_order().empty(),order==AtomOrder::INPUT,
+                   name+" order is stored");
+        test_value(plan.to_internal(plan.from_internal(moved))==moved,true,
+                   name+" renumbering round trips");
+        const DerivType pegy=plan.deriv(0),pgrad=plan.deriv(1,moved);
+        test_value(pegy.size(),egy.size(),name+" has every term");
+        for(const auto& di:egy){
+            const string msg=name+" "+di.first.first+" "+di.first.second;
+            const double tol=1e-10*std::max(1.0,std::fabs(di.second[0]));
+            compare_vectors(pegy.at(di.first),di.second,tol,msg+" energy");
+            compare_vectors(pgrad.at(di.first),grad.at(di.first),1e-8,
+                            msg+" gradient");
+        }
+    }
+
+    test_footer();
+    return 0;
+} //End main
@@ -51,6 +51,26 @@ TEST_THROW(d=FS.deriv(0,ps,{theta}),"thetas.size()!=ns.size()");
     compare_vectors(FS.deriv(1,ps,{theta}),grad,1e-5,"Fourier series gradient");
     compare_vectors(FS.deriv(2,ps,{theta}),hess,1e-5,"Fourier series Hessian");
 
+    //Three terms per angle, phases of 0 and 180 degrees use the recurrence
+    ps[Param_t::amp]=Vector({3.2,2.2,1.2,0.5,1.5,2.5,0.7,0.8,0.9});
+    ps[Param_t::phi]=Vector({0.0,M_PI,0.0,M_PI,0.3,0.0,-M_PI,0.0,M_PI});
+    ps[Param_t::n]=Vector({1.0,2.0,3.0,0.0,4.0,6.0,3.0,2.5,12.0});
+    Vector egy2(1,0.0),grad2(3,0.0),hess2(9,0.0);
+    for(size_t i=0;i<3;++i)
+        for(size_t j=0;j<3;++j){
+            const double V=ps[Param_t::amp][i*3+j],n=ps[Param_t::n][i*3+j],
+                         x=n*theta[i]-ps[Param_t::phi][i*3+j];
+            egy2[0]+=V+(n==0.0?0.0:V*std::cos(x));
+            grad2[i]-=V*n*std::sin(x);
+            hess2[i*3+i]-=V*n*n*std::cos(x);
+        }
+    compare_vectors(FS.deriv(0,ps,{theta}),egy2,1e-10,
+                    "Fourier series energy, integer periodicities");
+    compare_vectors(FS.deriv(1,ps,{theta}),grad2,1e-10,
+                    "Fourier series gradient, integer periodicities");
+    compare_vectors(FS.deriv(2,ps,{theta}),hess2,1e-10,
+                    "Fourier series Hessian, integer periodicities");
+
     test_footer();
     return 0;
 } //End main
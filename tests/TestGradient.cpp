@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include "TestMacros.hpp"
+#include "testdata/crambin.hpp"
+
+using namespace std;
+using namespace FManII;
+
+//The gradient and energies the long way, one vector per term
+Vector sum_terms(const DerivType& d,size_t n){
+    Vector rv(n,0.0);
+    for(const auto& di:d)
+        for(size_t i=0;i<n;++i)rv[i]+=di.second[i];
+    return rv;
+}
+
+int main(int argc, char** argv){
+    test_header("Testing summed gradients");
+    const Molecule mol=get_coords(crambin,crambin_conns);
+    const ParamSet ps=assign_params(mol,charmm22,crambin_FF_types);
+    const DerivType egy=deriv(0,charmm22,ps,mol);
+    const Vector corr=sum_terms(deriv(1,charmm22,ps,mol),crambin.size());
+
+    for(size_t nthreads:{1,4}){
+        set_num_threads(nthreads);
+        const string threads=" with "+to_string(nthreads)+" threads";
+        Vector grad(crambin.size(),0.0);
+        add_gradient(charmm22,ps,mol,grad);
+        compare_vectors(grad,corr,1e-10,"Summed gradient"+threads);
+
+        //The gradient is added to what's in the buffer
+        EnergyType egys;
+        add_gradient(charmm22,ps,mol,grad,&egys);
+        for(double& gi:grad)gi/=2.0;
+        compare_vectors(grad,corr,1e-10,"Gradient is accumulated"+threads);
+        test_value(egys.size(),egy.size(),"One energy per term"+threads);
+        for(const auto& ei:egy)
+            test_value(egys.at(ei.first),ei.second[0],1e-8,
+                       "Energy of "+ei.first.first+" "+ei.first.second+
+                       threads);
+    }
+    set_num_threads(1);
+
+    //Only the kept terms are added
+    const TermFilter no_pairs=skip_terms({},{IntCoord_t::PAIR});
+    Vector grad(crambin.size(),0.0);
+    EnergyType egys;
+    add_gradient(charmm22,ps,mol,grad,&egys,no_pairs);
+    compare_vectors(grad,sum_terms(deriv(1,charmm22,ps,mol,no_pairs),
+                                   crambin.size()),1e-10,"Filtered gradient");
+    test_value(egys.count(Terms_t::LJ),size_t(0),"No energy for skipped terms");
+
+    //Through a plan the gradient is in the caller's numbering
+    EvaluationPlan plan(crambin,crambin_conns,charmm22,crambin_FF_types,nullptr,
+                        AtomOrder::HILBERT);
+    grad.assign(crambin.size(),0.0);
+    plan.add_gradient(crambin,grad);
+    compare_vectors(grad,corr,1e-10,"Plan gradient");
+
+    Vector too_short(3,0.0);
+    TEST_THROW(add_gradient(charmm22,ps,mol,too_short),
+               "Gradient must have 3 elements per atom");
+
+    test_footer();
+    return 0;
+} //End main
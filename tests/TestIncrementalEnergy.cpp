@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include "TestMacros.hpp"
+#include "testdata/crambin.hpp"
+
+using namespace std;
+using namespace FManII;
+
+//The total energy from scratch
+double full_energy(const EvaluationPlan& plan,const Vector& carts){
+    EvaluationPlan moved(plan);
+    double rv=0.0;
+    for(const auto& di:moved.deriv(0,carts))rv+=di.second[0];
+    return rv;
+}
+
+int main(int argc, char** argv){
+    test_header("Testing incremental energies");
+    for(AtomOrder order:{AtomOrder::INPUT,AtomOrder::HILBERT}){
+        const string name=order==AtomOrder::INPUT?" (input order)":
+                                                   " (Hilbert order)";
+        const EvaluationPlan plan(crambin,crambin_conns,charmm22,
+                                  crambin_FF_types,nullptr,order);
+        IncrementalEnergy inc(plan);
+        const double e0=full_energy(plan,crambin);
+        test_value(inc.energy(),e0,1e-10,"Starting energy"+name);
+
+        //One atom
+        Vector carts(crambin);
+        const IVector one({17});
+        const Vector pos1({carts[51]+0.1,carts[52]-0.05,carts[53]+0.08});
+        copy(pos1.begin(),pos1.end(),carts.begin()+51);
+        const double e1=full_energy(plan,carts);
+        test_value(inc.propose(one,pos1),e1-e0,1e-10,"One atom move"+name);
+        TEST_THROW(inc.propose(one,pos1),"One move at a time");
+        inc.reject();
+        test_value(inc.energy(),e0,0.0,"Rejected move"+name);
+        compare_vectors(inc.carts(),crambin,0.0,"Rejected move geometry"+name);
+
+        //Same move again, then accepted
+        test_value(inc.propose(one,pos1),e1-e0,1e-10,"Move again"+name);
+        inc.accept();
+        test_value(inc.energy(),e1,1e-10,"Accepted move"+name);
+        compare_vectors(inc.carts(),carts,0.0,"Accepted move geometry"+name);
+
+        //A residue's worth of atoms, after the first move
+        IVector residue;
+        Vector pos;
+        for(size_t i=40;i<52;++i){
+            residue.push_back(i);
+            for(size_t x=0;x<3;++x){
+                carts[3*i+x]+=0.03*std::sin(i+x);
+                pos.push_back(carts[3*i+x]);
+            }
+        }
+        const double e2=full_energy(plan,carts);
+        test_value(inc.propose(residue,pos),e2-e1,1e-10,"Residue move"+name);
+        inc.accept();
+        test_value(inc.energy(),e2,1e-10,"Energy after two moves"+name);
+        for(const auto& ei:inc.energies()){
+            EvaluationPlan moved(plan);
+            test_value(ei.second,moved.deriv(0,carts).at(ei.first)[0],1e-10,
+                       "Energy of "+ei.first.first+" "+ei.first.second+name);
+        }
+    }
+
+    //Only the terms of the plan are tracked
+    const EvaluationPlan bonded(crambin,crambin_conns,charmm22,crambin_FF_types,
+                                nullptr,AtomOrder::INPUT,true,
+                                skip_terms({},{IntCoord_t::PAIR}));
+    IncrementalEnergy inc(bonded);
+    test_value(inc.energies().count(Terms_t::LJ),size_t(0),"Filtered terms");
+    Vector carts(crambin);
+    carts[0]+=0.1;
+    test_value(inc.propose({0},{carts[0],carts[1],carts[2]}),
+               full_energy(bonded,carts)-full_energy(bonded,crambin),1e-10,
+               "Filtered move");
+    inc.reject();
+    TEST_THROW(inc.reject(),"Nothing to reject");
+    TEST_THROW(inc.propose(IVector(1,crambin.size()),Vector(3)),
+               "Atoms must be in the system");
+    TEST_THROW(inc.propose(IVector(1,0),Vector(2)),"Three coordinates per atom");
+
+    //An atom listed twice is refused and leaves nothing half done
+    const double e0=inc.energy();
+    TEST_THROW(inc.propose(IVector(2,17),Vector(6,1.0)),"Atom moved twice");
+    TEST_THROW(inc.reject(),"Refused move isn't pending");
+    compare_vectors(inc.carts(),crambin,0.0,"Refused move geometry");
+    test_value(inc.energy(),e0,0.0,"Refused move energy");
+
+    //Rejecting a move of several atoms, in any order, puts all of them back
+    const IVector several({30,5,17});
+    Vector shifted;
+    for(size_t ai:several)
+        for(size_t x=0;x<3;++x)shifted.push_back(crambin[3*ai+x]+0.1);
+    inc.propose(several,shifted);
+    inc.reject();
+    compare_vectors(inc.carts(),crambin,0.0,"Rejected move of several atoms");
+    test_value(inc.propose({0},{carts[0],carts[1],carts[2]}),
+               full_energy(bonded,carts)-full_energy(bonded,crambin),1e-10,
+               "Deltas still right after rejected moves");
+
+    test_footer();
+    return 0;
+} //End main
@@ -16,6 +16,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
  * MA 02110-1301  USA
  */
+#include <ForceManII/FManII.hpp>
 #include <ForceManII/FFTerm.hpp>
 #include <ForceManII/ModelPotentials/LennardJones.hpp>
 #include "TestMacros.hpp"
@@ -46,6 +47,50 @@ TEST_THROW(c=lj.deriv(0,ps,{qs}),"epsilons.size()==dist.size()");
     compare_vectors(lj.deriv(1,ps,{qs}),grad,1e-5,"Lennard-Jones Gradient");
     compare_vectors(lj.deriv(2,ps,{qs}),hess,1e-5,"Lennard-Jones Hessian");
 
+    //Same potential, but with the coefficients combined ahead of time
+    map<string,Vector> ab;
+    for(size_t i=0;i<qs.size();++i){
+        const double s6=std::pow(ps[Param_t::sigma][i],6),
+                     e=ps[Param_t::epsilon][i];
+        ab[Param_t::A].push_back(e*s6*s6);
+        ab[Param_t::B].push_back(2.0*e*s6);
+    }
+    compare_vectors(lj.deriv(0,ab,{qs}),egy,1e-5,"Lennard-Jones A/B Energy");
+    compare_vectors(lj.deriv(1,ab,{qs}),grad,1e-5,"Lennard-Jones A/B Gradient");
+    compare_vectors(lj.deriv(2,ab,{qs}),hess,1e-5,"Lennard-Jones A/B Hessian");
+
+    //The class-pair table follows changes to the force field it came from
+    const LJTable table=amber99.lj_table(Terms_t::LJ);
+    ForceField ff(amber99);
+    compare_vectors(ff.lj_table(Terms_t::LJ).A,table.A,0.0,"Copied table");
+    ff.combrules[{Model_t::LENNARD_JONES,Param_t::sigma}]=geometric;
+    test_value(ff.lj_table(Terms_t::LJ).A!=table.A,true,"Edited force field");
+
+    //assign_params gives 6-12 terms A and B rather than sigma and epsilon
+    const Molecule mol=get_coords(ubiquitin,ubiquitin_conns);
+    const ParamSet assigned=assign_params(mol,amber99,ubiquitin_FF_types);
+    const map<string,Vector>& lj_ps=assigned.at(Terms_t::LJ);
+    test_value(lj_ps.count(Param_t::sigma)+lj_ps.count(Param_t::epsilon),
+               size_t(0),"No sigma or epsilon");
+    const AtomTuples& pairs=mol.atom_numbers.at(IntCoord_t::PAIR);
+    test_value(lj_ps.at(Param_t::A).size(),pairs.size(),"One A per pair");
+    test_value(lj_ps.at(Param_t::B).size(),pairs.size(),"One B per pair");
+    const Vector sigma=amber99.assign_param(Terms_t::LJ,Param_t::sigma,pairs,
+                                            ubiquitin_FF_types,true),
+                 eps=amber99.assign_param(Terms_t::LJ,Param_t::epsilon,pairs,
+                                          ubiquitin_FF_types,true);
+    //Relative differences, the coefficients span many orders of magnitude
+    Vector dA,dB;
+    for(size_t i=0;i<pairs.size();++i){
+        const double s6=std::pow(sigma[i],6),A=eps[i]*s6*s6,B=2.0*eps[i]*s6;
+        dA.push_back(A?lj_ps.at(Param_t::A)[i]/A-1.0:lj_ps.at(Param_t::A)[i]);
+        dB.push_back(B?lj_ps.at(Param_t::B)[i]/B-1.0:lj_ps.at(Param_t::B)[i]);
+    }
+    compare_vectors(dA,Vector(pairs.size(),0.0),1e-12,
+                    "A from sigma and epsilon");
+    compare_vectors(dB,Vector(pairs.size(),0.0),1e-12,
+                    "B from sigma and epsilon");
+
     test_footer();
     return 0;
 } //End main
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include "TestMacros.hpp"
+#include "testdata/crambin.hpp"
+
+using namespace std;
+using namespace FManII;
+
+int main(int argc, char** argv){
+    test_header("Testing geometry optimization");
+    //A bent, stretched water goes to the force field's bond length and angle
+    const IVector types({2001,2002,2002});
+    const ConnData conns({{1,2},{0},{0}});
+    const Vector water({0.0,0.0,0.0,2.1,0.3,0.0,-0.5,1.6,0.2});
+    EvaluationPlan plan(water,conns,amber99,types);
+    MinimizeOptions opts;
+    opts.grad_rms=1e-7;
+    opts.grad_max=1e-7;
+    const MinimizeResult rv=minimize(plan,water,opts);
+    test_value(rv.converged,true,"Water converged");
+    test_value(rv.nevals>=rv.nsteps+1,true,"At least one energy per step");
+    const double r0=plan.params().at(Terms_t::HO_BOND).at(Param_t::r0)[0],
+                 theta0=plan.params().at(Terms_t::HO_ANGLE).at(Param_t::r0)[0];
+    const Molecule& mol=plan.molecule();
+    compare_vectors(mol.coords.at(IntCoord_t::BOND),Vector(2,r0),1e-6,
+                    "Equilibrium bond lengths");
+    compare_vectors(mol.coords.at(IntCoord_t::ANGLE),Vector(1,theta0),1e-6,
+                    "Equilibrium angle");
+    test_value(rv.energy,0.0,1e-12,"Energy at the minimum");
+    Vector grad(water.size(),0.0);
+    plan.add_gradient(grad);
+    compare_vectors(grad,rv.grad,0.0,"Plan is left at the minimum");
+
+    //A protein only goes downhill, and stops when told to
+    EvaluationPlan protein(crambin,crambin_conns,charmm22,crambin_FF_types);
+    double e0=0.0;
+    for(const auto& di:protein.deriv(0))e0+=di.second[0];
+    MinimizeOptions few;
+    few.max_steps=25;
+    const MinimizeResult some=minimize(protein,crambin,few);
+    test_value(some.nsteps,size_t(25),"Stops after max_steps");
+    test_value(some.converged,false,"Not converged in a few steps");
+    test_value(some.energy<e0,true,"Energy went down");
+    double e1=0.0;
+    for(const auto& ei:some.energies)e1+=ei.second;
+    test_value(e1,some.energy,1e-12,"Total is the sum of the terms");
+    few.energy_change=1e300;
+    test_value(minimize(protein,crambin,few).nsteps,size_t(1),
+               "Energy change criterion");
+
+    MinimizeOptions bad;
+    bad.history=0;
+    TEST_THROW(minimize(plan,water,bad),"Need some history");
+
+    test_footer();
+    return 0;
+} //End main
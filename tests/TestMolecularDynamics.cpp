@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include "TestMacros.hpp"
+#include <algorithm>
+#include <sstream>
+
+using namespace std;
+using namespace FManII;
+
+//The largest change in the total energy over a CSV written by run()
+inline double energy_drift(const string& csv,size_t& nlines){
+    istringstream is(csv);
+    string line;
+    getline(is,line);
+    nlines=0;
+    double emin=1e300,emax=-1e300;
+    while(getline(is,line)){
+        ++nlines;
+        for(size_t i=0;i<4;++i)line=line.substr(line.find(',')+1);
+        const double e=stod(line.substr(0,line.find(',')));
+        emin=std::min(emin,e);
+        emax=std::max(emax,e);
+    }
+    return emax-emin;
+}
+
+int main(int argc, char** argv){
+    test_header("Testing molecular dynamics");
+    test_value(atomic_mass(6),12.011,"Mass of carbon");
+    test_value(atomic_number("Cl"),size_t(17),"Atomic number of chlorine");
+    TEST_THROW(atomic_number("Xx"),"Unknown element");
+    TEST_THROW(atomic_mass(0),"No element zero");
+    const Vector hoh=atom_masses({8,1,1});
+    test_value(hoh[1],1.008*amu2au,1e-10,"Masses in a.u.");
+
+    //A box of 27 waters
+    IVector types,Zs;
+    ConnData conns;
+    Vector carts;
+    const Vector water({0.0,0.0,0.0,1.8,0.2,0.0,-0.4,1.75,0.0});
+    for(size_t i=0;i<27;++i){
+        const size_t o=3*i;
+        types.insert(types.end(),{2001,2002,2002});
+        Zs.insert(Zs.end(),{8,1,1});
+        conns.insert(conns.end(),{{o+1,o+2},{o},{o}});
+        for(size_t j=0;j<3;++j){
+            carts.push_back(water[3*j]+5.8*(i%3));
+            carts.push_back(water[3*j+1]+5.8*(i/3%3));
+            carts.push_back(water[3*j+2]+5.8*(i/9));
+        }
+    }
+    const Vector masses=atom_masses(Zs);
+    EvaluationPlan plan(carts,conns,amber99,types);
+
+    //Constant energy
+    MDOptions nve;
+    nve.timestep=0.25*fs2au;
+    nve.output_every=10;
+    MolecularDynamics md(plan,carts,masses,nve);
+    test_value(md.kinetic_energy(),0.0,"Starts at rest");
+    md.set_temperature(300.0);
+    test_value(md.temperature(),300.0,1e-8,"Initial temperature");
+    double p=0.0;
+    const Vector v0=md.velocities();
+    for(size_t i=0;i<v0.size();i+=3)p+=masses[i/3]*v0[i];
+    test_value(p,0.0,1e-10,"No net momentum");
+    ostringstream csv,traj;
+    md.run(200,&csv,&traj);
+    test_value(md.step(),size_t(200),"Steps taken");
+    test_value(md.time(),200*nve.timestep,1e-10,"Time");
+    size_t nlines=0;
+    const double drift=energy_drift(csv.str(),nlines);
+    test_value(drift<5e-4,true,"Energy is conserved");
+    test_value(nlines,size_t(21),"One line per output");
+    istringstream traj_in(traj.str());
+    TrajectoryReader reader(traj_in,TrajFormat::BINARY);
+    Vector frame;
+    size_t nframes=0;
+    while(reader.next(frame))++nframes;
+    test_value(nframes,size_t(21),"One frame per output");
+    compare_vectors(frame,md.carts(),0.0,"Last frame is the current geometry");
+
+    //Velocity Verlet's error goes as the time step squared
+    MDOptions half=nve;
+    half.timestep/=2.0;
+    half.output_every=20;
+    MolecularDynamics fine(plan,carts,masses,half);
+    fine.set_velocities(v0);
+    ostringstream fine_csv;
+    fine.run(400,&fine_csv);
+    const double ratio=drift/energy_drift(fine_csv.str(),nlines);
+    test_value(ratio>3.0 && ratio<5.0,true,"Second order integrator");
+
+    //Same trajectory however the plan orders the atoms
+    EvaluationPlan hilbert(carts,conns,amber99,types,nullptr,AtomOrder::HILBERT);
+    MolecularDynamics md2(hilbert,carts,masses,nve);
+    md2.set_velocities(v0);
+    md2.run(200);
+    compare_vectors(md2.carts(),md.carts(),1e-8,"Atom order doesn't matter");
+
+    //Thermostats pull a cold system toward the target
+    for(Thermostat t:{Thermostat::BERENDSEN,Thermostat::LANGEVIN}){
+        MDOptions opts;
+        opts.thermostat=t;
+        opts.timestep=0.5*fs2au;
+        opts.coupling=10.0*fs2au;
+        opts.friction=1.0/(10.0*fs2au);
+        MolecularDynamics thermo(plan,carts,masses,opts);
+        thermo.set_temperature(50.0);
+        thermo.run(200);
+        double T=0.0;
+        for(size_t i=0;i<100;++i){
+            thermo.run(1);
+            T+=thermo.temperature()/100.0;
+        }
+        test_value(T>200.0 && T<400.0,true,"Thermostat reaches the target");
+        if(t!=Thermostat::LANGEVIN)continue;
+        MolecularDynamics again(plan,carts,masses,opts);
+        again.set_temperature(50.0);
+        again.run(300);
+        compare_vectors(again.carts(),thermo.carts(),0.0,
+                        "Same seed, same trajectory");
+    }
+
+    //A neighbor list doesn't change anything when the models are cut off
+    ForceField tab_ff(amber99);
+    tabulate_nonbonded(tab_ff,8192,1.0,9.0);
+    EvaluationPlan tab_plan(carts,conns,tab_ff,types);
+    MDOptions all=nve,listed=nve;
+    listed.cutoff=9.0;
+    listed.skin=1.0;
+    MolecularDynamics md_all(tab_plan,carts,masses,all),
+                      md_list(tab_plan,carts,masses,listed);
+    md_all.set_velocities(v0);
+    md_list.set_velocities(v0);
+    md_all.run(200);
+    md_list.run(200);
+    test_value(md_all.nlist_builds(),size_t(0),"No list without a cutoff");
+    test_value(md_list.nlist_builds()>=1,true,"List was built");
+    compare_vectors(md_list.carts(),md_all.carts(),1e-10,
+                    "Neighbor list geometry");
+    test_value(md_list.potential_energy(),md_all.potential_energy(),1e-12,
+               "Neighbor list energy");
+    MDOptions too_short=listed;
+    too_short.cutoff=8.0;
+    TEST_THROW(MolecularDynamics(tab_plan,carts,masses,too_short),
+               "Tables go past the cutoff");
+    TEST_THROW(MolecularDynamics(plan,carts,masses,listed),
+               "Analytic pair models never vanish");
+
+    //Bonds to hydrogen held fixed allow a 2 fs step: starting from a minimum
+    //the energy fluctuates far less than with the bonds free
+    const Vector relaxed=minimize(plan,carts).carts;
+    MDOptions shake;
+    shake.timestep=2.0*fs2au;
+    shake.output_every=5;
+    MolecularDynamics flexible(plan,relaxed,masses,shake);
+    flexible.set_temperature(300.0);
+    ostringstream flexible_csv;
+    flexible.run(100,&flexible_csv);
+    shake.constraints=Constraints::H_BONDS;
+    MolecularDynamics rigid(plan,relaxed,masses,shake);
+    test_value(rigid.nconstraints(),size_t(54),"Every water bond has an H");
+    rigid.set_temperature(300.0);
+    test_value(rigid.kinetic_energy(),0.5*(3*81-54)*kB_au*300.0,1e-12,
+               "Constraints remove degrees of freedom");
+    ostringstream rigid_csv;
+    rigid.run(100,&rigid_csv);
+    test_value(energy_drift(rigid_csv.str(),nlines)*4.0<
+               energy_drift(flexible_csv.str(),nlines),true,
+               "Energy is conserved better with constraints");
+    const double r0=plan.params().at(Terms_t::HO_BOND).at(Param_t::r0)[0];
+    const Vector xyz=rigid.carts(),vel=rigid.velocities();
+    double max_err=0.0,max_rv=0.0;
+    for(size_t i=0;i<27;++i)
+        for(size_t h=1;h<3;++h){
+            const size_t o=9*i,a=o+3*h;
+            const array<double,3> r={{xyz[a]-xyz[o],xyz[a+1]-xyz[o+1],
+                                      xyz[a+2]-xyz[o+2]}},
+                                  dv={{vel[a]-vel[o],vel[a+1]-vel[o+1],
+                                       vel[a+2]-vel[o+2]}};
+            max_err=std::max(max_err,std::fabs(std::sqrt(r[0]*r[0]+r[1]*r[1]+
+                                                         r[2]*r[2])-r0));
+            max_rv=std::max(max_rv,std::fabs(r[0]*dv[0]+r[1]*dv[1]+
+                                             r[2]*dv[2]));
+        }
+    test_value(max_err<1e-8,true,"Bonds stay at r0");
+    test_value(max_rv<1e-10,true,"No velocity along the bonds");
+
+    //Which bonds are picked depends on the masses
+    const Vector heavy(81,16.0*amu2au);
+    shake.constraints=Constraints::H_BONDS;
+    test_value(MolecularDynamics(plan,carts,heavy,shake).nconstraints(),
+               size_t(0),"No hydrogens");
+    shake.constraints=Constraints::ALL_BONDS;
+    test_value(MolecularDynamics(plan,carts,heavy,shake).nconstraints(),
+               size_t(54),"All bonds");
+
+    //A bond the force field has no parameters for isn't constrained
+    const ConnData linked({{1,2,3},{0},{0},{0,4,5},{3},{3}});
+    const Vector dimer({0.0,0.0,0.0,1.8,0.2,0.0,-0.4,1.75,0.0,
+                        5.6,0.3,-0.4,7.4,0.5,-0.4,5.2,2.05,-0.4});
+    const IVector dimer_types({2001,2002,2002,2001,2002,2002});
+    EvaluationPlan linked_plan(dimer,linked,amber99,dimer_types);
+    const Vector& linked_r0=
+        linked_plan.params().at(Terms_t::HO_BOND).at(Param_t::r0);
+    test_value(size_t(count(linked_r0.begin(),linked_r0.end(),0.0)),size_t(1),
+               "O-O bond has no parameters");
+    MolecularDynamics partial(linked_plan,dimer,atom_masses({8,1,1,8,1,1}),
+                              shake);
+    test_value(partial.nconstraints(),size_t(4),"Only the O-H bonds");
+    partial.run(10);
+    test_value(partial.step(),size_t(10),"Runs with a missing bond");
+
+    TEST_THROW(MolecularDynamics(plan,carts,Vector(3,1.0)),"Need masses");
+
+    test_footer();
+    return 0;
+} //End main
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include "TestMacros.hpp"
+#include "testdata/crambin.hpp"
+
+using namespace std;
+using namespace FManII;
+
+int main(int argc, char** argv){
+    test_header("Testing the fused nonbonded kernel");
+    //CHARMM22's 1-4 pairs aren't scaled, scale them so the factors are tested
+    ForceField ff(charmm22);
+    ff.scale_factors[Terms_t::LJ14]=0.5;
+    ff.scale_factors[Terms_t::CL14]=1.0/1.2;
+    ff.scale_factors[Terms_t::CL]=0.9;
+    Molecule mol=get_coords(crambin,crambin_conns);
+    const ParamSet ps=assign_params(mol,ff,crambin_FF_types);
+
+    //The same parameters as sigma and epsilon, which the kernel converts
+    ParamSet se(ps);
+    for(const FFTerm_t& term:{Terms_t::LJ,Terms_t::LJ14}){
+        const AtomTuples& pairs=mol.atom_numbers.at(term.second);
+        se[term].clear();
+        for(const string p:{Param_t::sigma,Param_t::epsilon})
+            se[term][p]=ff.assign_param(term,p,pairs,crambin_FF_types,true);
+    }
+
+    //A second geometry, for nonbonded_add's geom argument
+    Vector moved(crambin);
+    for(size_t i=0;i<moved.size();++i)moved[i]+=0.05*std::sin(i);
+    Molecule moved_mol=mol;
+    update_coords(moved_mol,moved);
+
+    for(const string pair_type:{IntCoord_t::PAIR,IntCoord_t::PAIR14}){
+        test_value(can_fuse(ff,ps,pair_type),true,"Can fuse "+pair_type);
+        const FFTerm_t lj_term(Model_t::LENNARD_JONES,pair_type),
+                       cl_term(Model_t::ELECTROSTATICS,pair_type);
+        const double lj_scale=ff.scale_factors.count(lj_term)?
+                              ff.scale_factors.at(lj_term):1.0,
+                     cl_scale=ff.scale_factors.count(cl_term)?
+                              ff.scale_factors.at(cl_term):1.0;
+
+        //The unfused path: each term's model, scaled afterwards
+        map<FFTerm_t,Vector> corr[2],corr_moved;
+        for(size_t order=0;order<2;++order)
+            for(const FFTerm_t& term:{lj_term,cl_term}){
+                Vector d=ff.terms.at(term).deriv(order,ps.at(term),mol);
+                const double scale=term==lj_term?lj_scale:cl_scale;
+                for(double& di:d)di*=scale;
+                corr[order][term]=d;
+                if(order)continue;
+                d=ff.terms.at(term).deriv(order,ps.at(term),moved_mol);
+                corr_moved[term]=Vector(1,d[0]*scale);
+            }
+
+        for(size_t nthreads:{1,4}){
+            set_num_threads(nthreads);
+            const string name=" "+pair_type+" "+to_string(nthreads)+
+                              " thread(s)";
+            for(size_t order=0;order<2;++order)
+                for(const ParamSet* params:{&ps,(const ParamSet*)&se}){
+                    DerivType fused;
+                    nonbonded_deriv(order,ff,*params,mol,pair_type,fused);
+                    const string what=name+" order "+to_string(order)+
+                                      (params==&ps?" A/B":" sigma/epsilon");
+                    compare_vectors(fused.at(lj_term),corr[order].at(lj_term),
+                                    1e-9,"LJ"+what);
+                    compare_vectors(fused.at(cl_term),corr[order].at(cl_term),
+                                    1e-9,"Electrostatics"+what);
+                }
+
+            //Adds to what's there, separately or into one buffer
+            const size_t n=crambin.size();
+            Vector lj(n,1.0),cl(n,2.0),both(n,0.0),lj_sum(n),cl_sum(n),
+                   total(n);
+            double elj=0.0,ecl=0.0;
+            nonbonded_add(ff,ps,mol,pair_type,lj.data(),cl.data(),&elj,&ecl);
+            nonbonded_add(ff,ps,mol,pair_type,both.data(),both.data(),nullptr,
+                          nullptr);
+            for(size_t i=0;i<n;++i){
+                lj_sum[i]=corr[1].at(lj_term)[i]+1.0;
+                cl_sum[i]=corr[1].at(cl_term)[i]+2.0;
+                total[i]=corr[1].at(lj_term)[i]+corr[1].at(cl_term)[i];
+            }
+            compare_vectors(lj,lj_sum,1e-9,"Added LJ gradient"+name);
+            compare_vectors(cl,cl_sum,1e-9,"Added electrostatic gradient"+name);
+            compare_vectors(both,total,1e-9,"Shared gradient buffer"+name);
+            test_value(elj,corr[0].at(lj_term)[0],1e-9,"LJ energy"+name);
+            test_value(ecl,corr[0].at(cl_term)[0],1e-9,
+                       "Electrostatic energy"+name);
+
+            //Another geometry, without updating the molecule
+            nonbonded_add(ff,ps,mol,pair_type,nullptr,nullptr,&elj,&ecl,
+                          &moved);
+            test_value(elj,corr_moved.at(lj_term)[0],1e-9,
+                       "LJ energy, other geometry"+name);
+            test_value(ecl,corr_moved.at(cl_term)[0],1e-9,
+                       "Electrostatic energy, other geometry"+name);
+        }
+    }
+    set_num_threads(1);
+
+    //Other models go through the unfused path
+    ForceField tab(ff);
+    tabulate_nonbonded(tab);
+    test_value(can_fuse(tab,ps,IntCoord_t::PAIR),false,"Tables aren't fused");
+    Vector buf(crambin.size(),0.0);
+    TEST_THROW(nonbonded_add(ff,ps,mol,IntCoord_t::PAIR,buf.data(),nullptr,
+                             nullptr,nullptr),"Need both gradients");
+
+    test_footer();
+    return 0;
+} //End main
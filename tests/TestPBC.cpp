@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include "TestMacros.hpp"
+
+using namespace std;
+using namespace FManII;
+
+//Brute force search for the shortest image of dr
+inline double shortest_image(const Cell& cell,const array<double,3>& dr){
+    const auto& l=cell.lattice();
+    double best=1e300;
+    for(int i=-5;i<=5;++i)
+        for(int j=-5;j<=5;++j)
+            for(int k=-5;k<=5;++k){
+                double r2=0.0;
+                for(size_t x=0;x<3;++x){
+                    const double r=dr[x]+i*l[x]+j*l[3+x]+k*l[6+x];
+                    r2+=r*r;
+                }
+                best=min(best,r2);
+            }
+    return sqrt(best);
+}
+
+inline void compare_derivs(const DerivType& actual,const DerivType& corr,
+                           const string& msg){
+    test_value(actual.size(),corr.size(),msg+" number of terms");
+    for(const auto& di:corr)
+        compare_vectors(actual.at(di.first),di.second,1e-8,
+                        msg+" "+di.first.first+" "+di.first.second);
+}
+
+int main(int argc, char** argv){
+    test_header("Testing periodic boundary conditions");
+
+    Cell box(10.0,12.0,14.0);
+    test_value(box.is_orthorhombic(),true,"Box is orthorhombic");
+    test_value(box.volume(),1680.0,1e-10,"Box volume");
+    compare_vectors({box.minimum_image({9.0,-7.0,0.5})[0],
+                     box.minimum_image({9.0,-7.0,0.5})[1],
+                     box.minimum_image({9.0,-7.0,0.5})[2]},
+                    {-1.0,5.0,0.5},1e-12,"Orthorhombic minimum image");
+
+    Cell tric({10.0,0.0,0.0,
+               6.0,9.0,0.0,
+               -3.0,4.0,11.0});
+    test_value(tric.is_orthorhombic(),false,"Triclinic cell detected");
+    const vector<array<double,3>> drs({{7.9,8.3,-2.2},{-14.0,3.0,9.5},
+                                       {0.3,-0.2,0.1},{12.0,-11.0,6.0}});
+    for(const auto& dr:drs){
+        const auto mi=tric.minimum_image(dr);
+        test_value(sqrt(mi[0]*mi[0]+mi[1]*mi[1]+mi[2]*mi[2]),
+                   shortest_image(tric,dr),1e-10,"Triclinic minimum image");
+    }
+    const Vector wrapped=tric.wrap({25.0,-3.0,40.0});
+    test_value(shortest_image(tric,{wrapped[0]-25.0,wrapped[1]+3.0,
+                                    wrapped[2]-40.0}),0.0,1e-10,
+               "Wrapping is a lattice translation");
+
+    //A water dimer, the isolated geometry is the reference
+    const IVector types({2001,2002,2002,2001,2002,2002});
+    const ConnData conns({{1,2},{0},{0},{4,5},{3},{3}});
+    const Vector water({0.0,0.0,0.0,1.8,0.2,0.0,-0.4,1.75,0.0});
+    const array<double,3> shift={5.6,0.3,-0.4};
+    Vector dimer(water);
+    for(size_t i=0;i<3;++i)
+        for(size_t j=0;j<3;++j)dimer.push_back(water[i*3+j]+shift[j]);
+    const DerivType egy=run_forcemanii(0,dimer,conns,amber99,types),
+                    grad=run_forcemanii(1,dimer,conns,amber99,types);
+
+    //Scatter atoms across the boundaries of the cell
+    const Cell cell(20.0,20.0,20.0);
+    Vector scattered(dimer);
+    scattered[3]+=20.0;  //Bonded atom moved one cell over
+    scattered[13]-=40.0; //Second water's first H, two cells over
+    scattered[9]-=20.0;  //Second water's O moved and
+    scattered[15]-=20.0; //the other H follows it
+    compare_derivs(run_forcemanii(0,scattered,conns,amber99,types,&cell),
+                   egy,"PBC energy");
+    compare_derivs(run_forcemanii(1,scattered,conns,amber99,types,&cell),
+                   grad,"PBC gradient");
+
+    Molecule mol=get_coords(scattered,conns,&cell);
+    test_value(*mol.cell==cell,true,"Molecule keeps the cell");
+    test_value(mol.coords.at(IntCoord_t::BOND)[0],
+               get_coords(dimer,conns).coords.at(IntCoord_t::BOND)[0],1e-10,
+               "Minimum image bond length");
+
+    test_footer();
+    return 0;
+} //End main
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include "TestMacros.hpp"
+#include "testdata/crambin.hpp"
+
+using namespace std;
+using namespace FManII;
+
+int main(int argc, char** argv){
+    test_header("Testing threaded evaluation");
+    test_value(get_num_threads(),size_t(1),"Serial by default");
+
+    set_num_threads(4);
+    test_value(get_num_threads(),size_t(4),"Number of threads");
+    vector<size_t> hits(10,0);
+    const size_t nchunks=parallel_for(hits.size(),
+                                      [&](size_t,size_t begin,size_t end){
+        for(size_t i=begin;i<end;++i)++hits[i];
+    });
+    test_value(nchunks,size_t(4),"Number of chunks");
+    test_value(hits,vector<size_t>(10,1),"Chunks cover the range once");
+    test_value(parallel_for(2,[](size_t,size_t,size_t){}),size_t(2),
+               "No more chunks than items");
+    TEST_THROW(parallel_for(8,[](size_t chunk,size_t,size_t){
+                   if(chunk==2)throw runtime_error("Chunk 2 failed");
+               }),"Exceptions are rethrown");
+    {
+        SerialRegion serial;
+        test_value(get_num_threads(),size_t(1),"Serial region has one thread");
+        test_value(parallel_for(8,4,[](size_t,size_t,size_t){}),size_t(1),
+                   "Serial region makes one chunk");
+    }
+    test_value(get_num_threads(),size_t(4),"Serial region is restored");
+
+    set_num_threads(1);
+    const Molecule mol=get_coords(crambin,crambin_conns);
+    const ParamSet ps=assign_params(mol,charmm22,crambin_FF_types);
+    const DerivType egy=deriv(0,charmm22,ps,mol),grad=deriv(1,charmm22,ps,mol);
+    set_num_threads(3);
+    const DerivType egy3=deriv(0,charmm22,ps,mol),
+                    grad3=deriv(1,charmm22,ps,mol);
+    test_value(egy3.size(),egy.size(),"Same terms");
+    for(const auto& di:egy){
+        const string msg=di.first.first+" "+di.first.second;
+        compare_vectors(egy3.at(di.first),di.second,1e-10,msg+" energy");
+        compare_vectors(grad3.at(di.first),grad.at(di.first),1e-10,
+                        msg+" gradient");
+    }
+
+    test_footer();
+    return 0;
+} //End main
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include "TestMacros.hpp"
+#include "testdata/peptide.hpp"
+#include <set>
+#include <sstream>
+
+using namespace std;
+using namespace FManII;
+
+int main(int argc, char** argv){
+    test_header("Testing profiling");
+    reset_profile();
+    const Molecule mol=get_coords(peptide,peptide_conns);
+    const ParamSet ps=assign_params(mol,oplsaa,peptide_FF_types);
+    deriv(0,oplsaa,ps,mol);
+    deriv(1,oplsaa,ps,mol);
+    const Profile prof=get_profile();
+    if(!profiling_enabled()){
+        test_value(prof.phases.empty(),true,"Nothing recorded when disabled");
+        start_trace();
+        deriv(1,oplsaa,ps,mol);
+        stop_trace();
+        test_value(get_trace().empty(),true,"Nothing traced when disabled");
+        test_footer();
+        return 0;
+    }
+
+    size_t ncoords=0;
+    for(const auto& ci:mol.atom_numbers)ncoords+=ci.second.size();
+    const ProfileEntry& gc=prof.phases.at("get_coords").total;
+    test_value(gc.calls,size_t(1),"get_coords calls");
+    test_value(gc.ncoords,ncoords,"get_coords coordinates");
+    test_value(gc.bytes>=ncoords*sizeof(double),true,"get_coords bytes");
+
+    const PhaseProfile& ap=prof.phases.at("assign_params");
+    test_value(ap.total.calls,size_t(1),"assign_params calls");
+    test_value(ap.terms.size(),ps.size(),"assign_params terms");
+
+    const PhaseProfile& d=prof.phases.at("deriv");
+    test_value(d.total.calls,size_t(2),"deriv calls");
+    test_value(d.terms.size(),ps.size(),"deriv terms");
+    double term_time=0.0;
+    size_t term_coords=0;
+    for(const auto& ti:d.terms){
+        const size_t n=mol.atom_numbers.at(ti.first.second).size();
+        test_value(ti.second.calls,size_t(2),ti.first.first+" "+
+                   ti.first.second+" calls");
+        test_value(ti.second.ncoords,2*n,ti.first.first+" "+
+                   ti.first.second+" coordinates");
+        term_time+=ti.second.seconds;
+        term_coords+=ti.second.ncoords;
+    }
+    test_value(term_coords,d.total.ncoords,"Terms add up to the phase");
+    test_value(term_time<=d.total.seconds,true,"Terms take less than phase");
+
+    reset_profile();
+    test_value(get_profile().phases.empty(),true,"Profile resets");
+
+    //Tracing, with two threads so the chunks show up
+    test_value(get_trace().empty(),true,"Nothing traced before start_trace");
+    set_num_threads(2);
+    start_trace();
+    const Molecule mol2=get_coords(peptide,peptide_conns);
+    deriv(1,oplsaa,ps,mol2);
+    stop_trace();
+    set_num_threads(1);
+    const vector<TraceEvent> trace=get_trace();
+    size_t nphases=0,nterms=0;
+    set<size_t> chunk_threads;
+    for(const TraceEvent& e:trace){
+        test_value(e.duration_us>=0.0 && e.start_us>=0.0,true,
+                   e.name+" has a valid span");
+        if(e.category=="phase")++nphases;
+        else if(e.category=="deriv")++nterms;
+        else if(e.category=="parallel")chunk_threads.insert(e.thread);
+    }
+    test_value(nphases,size_t(2),"get_coords and deriv are traced");
+    test_value(nterms>0 && nterms<=ps.size(),true,"Terms are traced");
+    test_value(chunk_threads.size()>=2,true,"Chunks are traced per thread");
+    deriv(0,oplsaa,ps,mol2);
+    test_value(get_trace().size(),trace.size(),"Nothing traced after stop");
+    stringstream json;
+    write_trace(json);
+    test_value(json.str().find("\"traceEvents\"")!=string::npos,true,
+               "Trace is written in Chrome's format");
+    test_footer();
+    return 0;
+} //End main
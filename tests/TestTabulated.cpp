@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include "TestMacros.hpp"
+
+using namespace std;
+using namespace FManII;
+
+int main(int argc, char** argv){
+    test_header("Testing tabulated pair potentials");
+    auto lj=make_shared<LennardJones>();
+    map<string,Vector> ps={
+        {Param_t::sigma,{M_PI/2.0,M_PI,M_PI/4.0}},
+        {Param_t::epsilon,{2.0,3.0,4.0}}};
+    map<string,Vector> ab;
+    for(size_t i=0;i<3;++i){
+        const double s6=std::pow(ps[Param_t::sigma][i],6),
+                     e=ps[Param_t::epsilon][i];
+        ab[Param_t::A].push_back(e*s6*s6);
+        ab[Param_t::B].push_back(2.0*e*s6);
+    }
+    const Vector qs({3.2,2.2,1.2});
+
+    //Second derivatives of the spline converge more slowly than the rest
+    const Vector tols({1e-5,1e-5,1e-1});
+
+    //One table per set of parameters
+    Tabulated tab(lj,16384,1.0,10.0);
+    test_value(tab.name,lj->name,"Tabulated model keeps the name");
+    for(size_t i=0;i<3;++i)
+        compare_vectors(tab.deriv(i,ps,{qs}),lj->deriv(i,ps,{qs}),tols[i],
+                        "Tabulated LJ derivative "+to_string(i));
+    test_value(tab.ntables(),size_t(3),"One table per parameter set");
+
+    //Shared tables for parameters the energy is linear in
+    Tabulated lin(lj,16384,1.0,10.0,{Param_t::A,Param_t::B});
+    for(size_t i=0;i<3;++i)
+        compare_vectors(lin.deriv(i,ab,{qs}),lj->deriv(i,ab,{qs}),tols[i],
+                        "Linear tabulated LJ derivative "+to_string(i));
+    test_value(lin.ntables(),size_t(1),"One table for linear parameters");
+
+    //Past the cutoff nothing, below the table the analytic form
+    const Vector far_close({12.0,0.8});
+    const map<string,Vector> ab2={{Param_t::A,{ab[Param_t::A][0],
+                                               ab[Param_t::A][2]}},
+                                  {Param_t::B,{ab[Param_t::B][0],
+                                               ab[Param_t::B][2]}}};
+    compare_vectors(lin.deriv(0,ab2,{far_close}),
+                    lj->deriv(0,{{Param_t::A,{ab[Param_t::A][2]}},
+                                 {Param_t::B,{ab[Param_t::B][2]}}},{{0.8}}),
+                    1e-10,"Cutoff and short-range energy");
+    const Vector g=lin.deriv(1,ab2,{far_close});
+    test_value(g[0],0.0,1e-12,"No gradient past the cutoff");
+    test_value(g[1],lj->deriv(1,ab2,{far_close})[1],1e-10,
+               "Analytic gradient below the table");
+
+    const TableAccuracy acc=lin.accuracy(ab,1000);
+    test_value(acc.nsamples,size_t(3000),"Accuracy report sample count");
+    test_value(acc.max_rel_egy_error<1e-7,true,"Accuracy report energy");
+    test_value(acc.max_rel_grad_error<1e-5,true,"Accuracy report gradient");
+    Tabulated coarse(lj,4096,1.0,10.0,{Param_t::A,Param_t::B});
+    test_value(coarse.accuracy(ab,1000).max_rel_egy_error>
+               acc.max_rel_egy_error,true,"Coarser tables are less accurate");
+
+    //Whole force field, the water dimer is well inside the cutoff
+    const IVector types({2001,2002,2002,2001,2002,2002});
+    const ConnData conns({{1,2},{0},{0},{4,5},{3},{3}});
+    const Vector dimer({0.0,0.0,0.0,1.8,0.2,0.0,-0.4,1.75,0.0,
+                        5.6,0.3,-0.4,7.4,0.5,-0.4,5.2,2.05,-0.4});
+    ForceField tab_ff(amber99);
+    tabulate_nonbonded(tab_ff,8192,1.0,20.0);
+    const FFTerm_t lj_term(Model_t::LENNARD_JONES,IntCoord_t::PAIR),
+                   cl_term(Model_t::ELECTROSTATICS,IntCoord_t::PAIR);
+    test_value(dynamic_cast<const Tabulated*>(
+                   &tab_ff.terms.at(lj_term).model())!=nullptr,true,
+               "Force field uses tables");
+    for(size_t order=0;order<2;++order){
+        const DerivType corr=run_forcemanii(order,dimer,conns,amber99,types),
+                        test=run_forcemanii(order,dimer,conns,tab_ff,types);
+        for(const FFTerm_t& term:{lj_term,cl_term})
+            compare_vectors(test.at(term),corr.at(term),1e-8,
+                            "Tabulated "+term.first+" order "+
+                            to_string(order));
+    }
+
+    test_footer();
+    return 0;
+} //End main
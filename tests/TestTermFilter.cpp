@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include "TestMacros.hpp"
+#include "testdata/crambin.hpp"
+
+using namespace std;
+using namespace FManII;
+
+int main(int argc, char** argv){
+    test_header("Testing term filters");
+    const TermFilter no_pairs=skip_terms({},{IntCoord_t::PAIR}),
+                     no_lj=skip_terms({Model_t::LENNARD_JONES},{}),
+                     angles=only_term(Terms_t::HO_ANGLE);
+    test_value(no_pairs(Terms_t::LJ),false,"Skip by coordinate");
+    test_value(no_pairs(Terms_t::LJ14),true,"Other coordinates kept");
+    test_value(no_lj(Terms_t::LJ14),false,"Skip by model");
+    test_value(no_lj(Terms_t::CL),true,"Other models kept");
+    test_value(angles(Terms_t::HO_ANGLE),true,"Only the term");
+    test_value(angles(Terms_t::HO_BOND),false,"Not the others");
+    const set<string> needed=coords_needed(charmm22,no_pairs);
+    test_value(needed.count(IntCoord_t::PAIR),size_t(0),"Pairs not needed");
+    test_value(needed.count(IntCoord_t::PAIR14),size_t(1),"1,4 pairs needed");
+    test_value(coords_needed(charmm22,angles),set<string>({IntCoord_t::ANGLE}),
+               "Coordinates of one term");
+
+    //Only the coordinates asked for are found, and they are the same ones
+    const Molecule all=get_coords(crambin,crambin_conns);
+    for(const set<string>& types:{set<string>({IntCoord_t::PAIR14}),
+                                  set<string>({IntCoord_t::PAIR,
+                                               IntCoord_t::ANGLE}),
+                                  set<string>({IntCoord_t::BOND,
+                                               IntCoord_t::PAIR13,
+                                               IntCoord_t::TORSION,
+                                               IntCoord_t::IMPTORSION})}){
+        const Molecule some=get_coords(crambin,crambin_conns,nullptr,&types);
+        set<string> found;
+        for(const auto& ci:some.atom_numbers)found.insert(ci.first);
+        test_value(found,types,"Found only the requested types");
+        for(const string& type:types){
+            test_value(vector<Index_t>(some.atom_numbers.at(type).data()),
+                       all.atom_numbers.at(type).data(),"Same atoms "+type);
+            compare_vectors(some.coords.at(type),all.coords.at(type),0.0,
+                            "Same values "+type);
+        }
+    }
+
+    //Rejected terms are never computed, the rest are unchanged
+    for(size_t order=0;order<2;++order){
+        const DerivType corr=run_forcemanii(order,crambin,crambin_conns,
+                                            charmm22,crambin_FF_types);
+        for(const TermFilter& filter:{no_pairs,no_lj,angles}){
+            const DerivType test=run_forcemanii(order,crambin,crambin_conns,
+                                                charmm22,crambin_FF_types,
+                                                nullptr,filter);
+            size_t nkept=0;
+            for(const auto& di:corr){
+                if(!filter(di.first))continue;
+                ++nkept;
+                compare_vectors(test.at(di.first),di.second,1e-12,
+                                di.first.first+" "+di.first.second+
+                                " order "+to_string(order));
+            }
+            test_value(test.size(),nkept,"Only kept terms computed");
+        }
+    }
+
+    const ParamSet ps=assign_params(all,charmm22,crambin_FF_types,true,angles);
+    test_value(ps.size(),size_t(1),"Only the kept term is assigned");
+    const ParamSet ps_all=assign_params(all,charmm22,crambin_FF_types);
+    test_value(deriv(1,charmm22,ps_all,all,angles).size(),size_t(1),
+               "deriv skips rejected terms");
+
+    EvaluationPlan plan(crambin,crambin_conns,charmm22,crambin_FF_types,nullptr,
+                        AtomOrder::INPUT,true,no_pairs);
+    test_value(plan.molecule().atom_numbers.count(IntCoord_t::PAIR),size_t(0),
+               "Plans don't find unneeded pairs");
+    const DerivType test=plan.deriv(1),
+                    corr=run_forcemanii(1,crambin,crambin_conns,charmm22,
+                                        crambin_FF_types,nullptr,no_pairs);
+    test_value(test.size(),corr.size(),"Plan computes the same terms");
+    for(const auto& di:corr)
+        compare_vectors(test.at(di.first),di.second,1e-12,
+                        "Plan "+di.first.first+" "+di.first.second);
+
+    test_footer();
+    return 0;
+} //End main
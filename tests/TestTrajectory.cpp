@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2016 Ryan M. Richard <ryanmrichard1 at gmail.com>.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301  USA
+ */
+#include <ForceManII/FManII.hpp>
+#include "TestMacros.hpp"
+#include "testdata/crambin.hpp"
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+using namespace std;
+using namespace FManII;
+
+const double ang2au=1.889725989;
+
+//Writes a frame in Tinker's format
+void write_tinker(ostream& os,const Vector& carts,const IVector& types,
+                  const ConnData& conns,bool box){
+    os.precision(17);
+    os<<types.size()<<" frame"<<endl;
+    if(box)os<<"  30.0 30.0 30.0 90.0 90.0 90.0"<<endl;
+    for(size_t i=0;i<types.size();++i){
+        os<<i+1<<" X";
+        for(size_t x=0;x<3;++x)os<<" "<<carts[3*i+x]/ang2au;
+        os<<" "<<types[i];
+        for(size_t j:conns[i])os<<" "<<j+1;
+        os<<endl;
+    }
+}
+
+int main(int argc, char** argv){
+    test_header("Testing trajectories");
+    const size_t n=crambin.size(),nframes=7;
+    vector<Vector> frames;
+    Vector all_frames;
+    for(size_t f=0;f<nframes;++f){
+        Vector carts(crambin);
+        for(size_t i=0;i<n;++i)carts[i]+=0.05*std::sin(0.3*i+f);
+        frames.push_back(carts);
+        all_frames.insert(all_frames.end(),carts.begin(),carts.end());
+    }
+
+    stringstream tinker;
+    for(size_t f=0;f<nframes;++f)
+        write_tinker(tinker,frames[f],crambin_FF_types,crambin_conns,f==1);
+    TrajectoryReader arc(tinker,TrajFormat::TINKER);
+    test_value(arc.natoms(),n/3,"Tinker number of atoms");
+    test_value(arc.types(),crambin_FF_types,"Tinker atom types");
+    test_value(arc.conns(),crambin_conns,"Tinker connectivity");
+    Vector carts;
+    for(size_t f=0;f<nframes;++f){
+        test_value(arc.next(carts),true,"Tinker frame "+to_string(f));
+        compare_vectors(carts,frames[f],1e-12,"Tinker frame "+to_string(f)+
+                        " coordinates");
+    }
+    test_value(arc.next(carts),false,"End of the Tinker trajectory");
+    test_value(arc.nframes(),nframes,"Tinker frames read");
+
+    stringstream binary;
+    write_binary_header(binary,n/3);
+    for(const Vector& frame:frames)write_binary_frame(binary,frame);
+    TrajectoryReader bin(binary,TrajFormat::BINARY);
+    test_value(bin.natoms(),n/3,"Binary number of atoms");
+    for(size_t f=0;f<nframes;++f){
+        test_value(bin.next(carts),true,"Binary frame "+to_string(f));
+        compare_vectors(carts,frames[f],0.0,"Binary frame "+to_string(f)+
+                        " coordinates");
+    }
+    test_value(bin.next(carts),false,"End of the binary trajectory");
+
+    stringstream bad("not a trajectory"),empty;
+    TEST_THROW(TrajectoryReader(bad,TrajFormat::BINARY),"Bad binary header");
+    TEST_THROW(TrajectoryReader(empty,TrajFormat::TINKER),"No frames");
+
+    //Rescoring gives the energies of a batch
+    const EvaluationPlan plan(crambin,crambin_conns,charmm22,crambin_FF_types);
+    vector<EnergyType> corr;
+    const Vector totals=plan.batch(all_frames,nullptr,&corr);
+    for(size_t nthreads:{1,3}){
+        set_num_threads(nthreads);
+        const string threads=" with "+to_string(nthreads)+" threads";
+        binary.clear();
+        binary.seekg(0);
+        TrajectoryReader reader(binary,TrajFormat::BINARY);
+        stringstream csv;
+        test_value(rescore(reader,plan,csv,EnergyFormat::CSV,3),nframes,
+                   "Frames rescored"+threads);
+        string line;
+        getline(csv,line);
+        test_value(line.substr(0,11),string("frame,total"),"CSV header");
+        for(size_t f=0;f<nframes;++f){
+            getline(csv,line);
+            stringstream row(line);
+            string cell;
+            getline(row,cell,',');
+            test_value(stoul(cell),f,"CSV frame number");
+            getline(row,cell,',');
+            test_value(stod(cell),totals[f],1e-12,"CSV total"+threads);
+            for(const auto& ti:plan.params()){
+                getline(row,cell,',');
+                test_value(stod(cell),corr[f].at(ti.first),1e-12,
+                           "CSV "+ti.first.first+" "+ti.first.second);
+            }
+        }
+    }
+    set_num_threads(1);
+
+    binary.clear();
+    binary.seekg(0);
+    TrajectoryReader reader(binary,TrajFormat::BINARY);
+    stringstream out;
+    rescore(reader,plan,out,EnergyFormat::BINARY,4);
+    char magic[8];
+    uint64_t ncols=0;
+    out.read(magic,8);
+    out.read(reinterpret_cast<char*>(&ncols),sizeof(ncols));
+    test_value(string(magic,8),string("FMIIEGY1"),"Binary energy header");
+    test_value(ncols,uint64_t(2+plan.params().size()),"Binary columns");
+    for(uint64_t i=0;i<ncols;++i){
+        uint64_t len=0;
+        out.read(reinterpret_cast<char*>(&len),sizeof(len));
+        out.ignore(len);
+    }
+    Vector rows(ncols*nframes);
+    out.read(reinterpret_cast<char*>(rows.data()),rows.size()*sizeof(double));
+    for(size_t f=0;f<nframes;++f)
+        test_value(rows[f*ncols+1],totals[f],0.0,"Binary total");
+
+    stringstream small;
+    write_binary_header(small,3);
+    TrajectoryReader wrong(small,TrajFormat::BINARY);
+    TEST_THROW(rescore(wrong,plan,out),"Number of atoms must match");
+
+    test_footer();
+    return 0;
+} //End main